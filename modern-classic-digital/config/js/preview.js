@@ -0,0 +1,316 @@
+// Live preview of the face on the configuration page, drawn on a canvas from the settings as
+// they're picked, the way the watchface draws them: its geometry and defaults come from
+// face-geometry.h and its day and month names from face-names.h, both headers the watchface
+// compiles, and its colors are reduced to the watch's.  The slots' formatting follows the
+// watchface's format* functions.
+
+// the displays, as the watchface's PBL_DISPLAY_WIDTH/HEIGHT, PBL_ROUND and PBL_BW, and PBL_HEALTH
+var kPreviewPlatforms =
+{
+	aplite:		{width: 144, height: 168, round: false, bw: true, health: false},
+	basalt:		{width: 144, height: 168, round: false, bw: false, health: true},
+	chalk:		{width: 180, height: 180, round: true, bw: false, health: true},
+	diorite:	{width: 144, height: 168, round: false, bw: true, health: true},
+	emery:		{width: 200, height: 228, round: false, bw: false, health: true},
+};
+
+// the watch's readings, which the page can't have, stand in for by samples: the charge, the
+// hours it would last, the day's steps and the heart rate
+var kPreviewCharge = 70, kPreviewHoursRemaining = 117, kPreviewSteps = 8421, kPreviewHeartRate = 64;
+
+// the slot sources, as the watchface's kSource*
+var kPreviewSourceWeekday = 1, kPreviewSourceMonth = 2, kPreviewSourceDate = 3, kPreviewSourceBattery = 4,
+	kPreviewSourceSteps = 5, kPreviewSourceHeartRate = 6, kPreviewSourceSecondZone = 7;
+
+// the watchface's language for the picker's, as its resolveLanguage does; its system locale is
+// the phone's here
+function previewLanguage(picked, languages)
+{
+	var language = parseInt(picked, 10) || 0;
+	if((language < 1) || (language > languages))
+	{
+		var iso = String(navigator.language || "en").toLowerCase().substring(0, 2);
+		language = {ar: 1, de: 2, en: 3, es: 4, fr: 5, it: 6, nl: 7, pt: 8, ru: 9}[iso] || 3;
+	}
+	return(language);
+}
+
+// the "#define name number" lines of a header, by name
+function parseDefines(text)
+{
+	var defines = {}, pattern = /^#define\s+(\w+)\s+(-?\d+)\s*$/gm, match;
+	while((match = pattern.exec(text)) !== null)
+		defines[match[1]] = parseInt(match[2], 10);
+	return(defines);
+}
+
+// the "name[] = { ... };" tables of string literals in a header, by name, leaving out what's
+// commented out
+function parseStringTables(text)
+{
+	var tables = {}, pattern = /(\w+)\[\]\s*=\s*\{([^}]*)\};/g, match;
+	while((match = pattern.exec(text)) !== null)
+	{
+		var body = match[2].replace(/\/\/[^\n]*/g, ""), strings = [], literal = /"((?:[^"\\]|\\.)*)"/g, string;
+		while((string = literal.exec(body)) !== null)
+			strings.push(string[1]);
+		tables[match[1]] = strings;
+	}
+	return(tables);
+}
+
+// the CSS color the watch shows for a hex color: 2 bits per channel, and black or white by
+// luminance on the 1-bit displays, as the watchface's reduceColors does
+function previewColor(colorHex, bw)
+{
+	var c = parseInt(String(colorHex).replace(/^#|^0x/, ""), 16) || 0,
+		r = (c >> 22) & 3, g = (c >> 14) & 3, b = (c >> 6) & 3;
+	if(bw)
+		r = g = b = (((2 * r) + (5 * g) + b) >= 12)? 3 : 0;
+	return("rgb(" + (r * 85) + "," + (g * 85) + "," + (b * 85) + ")");
+}
+
+function FacePreview(canvas, platform, geometry, names)
+{
+	this.canvas = canvas;
+	this.display = kPreviewPlatforms[platform] || kPreviewPlatforms.chalk;
+	this.geometry = geometry;
+	this.names = names;
+
+	canvas.width = this.display.width;
+	canvas.height = this.display.height;
+	if(this.display.round)
+		canvas.style.borderRadius = "50%";
+}
+
+// a length from face-geometry.h scaled to this dial, as kDialScale
+FacePreview.prototype.scale = function(length)
+{
+	return(Math.floor(((length * this.diameter) + 90) / 180));
+};
+
+// a ring of the given thickness inside the circle of the given radius, in elapsedColor from
+// 12 o'clock clockwise to splitAngle degrees and remainingColor after it
+FacePreview.prototype.ring = function(radius, thickness, splitAngle, elapsedColor, remainingColor)
+{
+	var ctx = this.ctx, top = -Math.PI / 2, split = top + (splitAngle * Math.PI / 180);
+	ctx.lineWidth = thickness;
+	ctx.lineCap = "butt";
+
+	ctx.strokeStyle = elapsedColor;
+	ctx.beginPath();
+	ctx.arc(this.cx, this.cy, radius - (thickness / 2), top, split, false);
+	ctx.stroke();
+
+	ctx.strokeStyle = remainingColor;
+	ctx.beginPath();
+	ctx.arc(this.cx, this.cy, radius - (thickness / 2), split, top + (2 * Math.PI), false);
+	ctx.stroke();
+};
+
+FacePreview.prototype.hand = function(angle, fromRadius, toRadius, width, color)
+{
+	var ctx = this.ctx, dx = Math.sin(angle * Math.PI / 180), dy = -Math.cos(angle * Math.PI / 180);
+	ctx.strokeStyle = color;
+	ctx.lineWidth = width;
+	ctx.lineCap = "round";
+	ctx.beginPath();
+	ctx.moveTo(this.cx + (dx * fromRadius), this.cy + (dy * fromRadius));
+	ctx.lineTo(this.cx + (dx * toRadius), this.cy + (dy * toRadius));
+	ctx.stroke();
+};
+
+FacePreview.prototype.text = function(string, box, size, color, smallSize)
+{
+	var ctx = this.ctx;
+	ctx.fillStyle = color;
+	ctx.font = "bold " + size + "px sans-serif";
+	// text too wide for its box takes the smaller size, as a slot's does
+	if(smallSize && (ctx.measureText(string).width > box.w))
+		ctx.font = "bold " + smallSize + "px sans-serif";
+	ctx.textAlign = "center";
+	ctx.textBaseline = "middle";
+	ctx.fillText(string, box.x + (box.w / 2), box.y + (box.h / 2));
+};
+
+// draws the face for the options getConfigData() returns, at the given time
+FacePreview.prototype.render = function(opts, now)
+{
+	var g = this.geometry, names = this.names, display = this.display, bw = display.bw;
+	function color(id) { return(previewColor(opts[id], bw)); }
+	function option(id) { return(opts[id] === true); }
+
+	this.ctx = this.canvas.getContext("2d");
+	this.diameter = Math.min(display.width, display.height);
+	this.cx = display.width / 2;
+	this.cy = display.height / 2;
+
+	// the same substitutions modern-classic-digital.js makes when it sends them
+	var customArcs = option("optionCustomArcColors_option"),
+		elapsedOuterColor = color(customArcs? "elapsedOuterColor_picker" : "minuteHandColor_picker"),
+		elapsedOuterBackground = color(customArcs? "elapsedOuterBackground_picker" : "elapsedBackground_picker"),
+		elapsedInnerColor = color(customArcs? "elapsedInnerColor_picker" : "hourHandColor_picker"),
+		elapsedInnerBackground = color(customArcs? "elapsedInnerBackground_picker" : "elapsedBackground_picker");
+
+	var radius = this.diameter / 2,
+		outerCircleOuterInset = this.scale(g.kDefaultOuterCircleOuterInset),
+		outerCircleInnerInset = this.scale(g.kDefaultOuterCircleInnerInset),
+		innerCircleOuterInset = outerCircleOuterInset + this.scale(g.kDefaultInnerCircleSpacing),
+		innerCircleInnerInset = this.scale(g.kDefaultInnerCircleInnerInset),
+		hourHandInset = outerCircleOuterInset + this.scale(g.kDefaultHourHandSpacing),
+		hourHandWidth = parseInt(opts["hourHandWidth_value"], 10) || this.scale(g.kDefaultHourHandWidth),
+		minuteHandWidth = parseInt(opts["minuteHandWidth_value"], 10) || this.scale(g.kDefaultMinuteHandWidth),
+		handRadius = radius - innerCircleOuterInset - innerCircleInnerInset;
+
+	// the time, or the demo mode's
+	var hours = now.getHours(), minutes = now.getMinutes(), day = now.getDate(), month = now.getMonth(), weekDay = now.getDay();
+	if(option("optionDemoMode_option"))
+	{
+		hours = 1;
+		minutes = 50;
+		day = 4;
+		month = 3;
+		weekDay = 5;
+	}
+	var pm = (hours >= 12),
+		hourAngle = ((pm? (hours - 12) : hours) * 30) + (option("optionHourHandSnap_option")? 0 : Math.floor(minutes / 2)),
+		minuteAngle = minutes * 6;
+
+	// the outer background, then the background inside the minute ring
+	var ctx = this.ctx;
+	ctx.fillStyle = color("outerBackgroundColor_picker");
+	ctx.fillRect(0, 0, display.width, display.height);
+	ctx.fillStyle = color("backgroundColor_picker");
+	ctx.beginPath();
+	ctx.arc(this.cx, this.cy, radius - outerCircleOuterInset, 0, 2 * Math.PI);
+	ctx.fill();
+
+	// the complications, in boxes laid out as the watchface's complicationBoxes, each showing
+	// the source picked for it as the watchface's format* would
+	var small = (this.diameter < 180),
+		outerRadius = outerCircleOuterInset + outerCircleInnerInset + g.kComplicationRingClearance,
+		innerRadius = innerCircleOuterInset - g.kComplicationRingClearance,
+		midRadius = Math.floor((outerRadius + innerRadius) / 2),
+		w = this.scale(g.kComplicationHalfWidth), h = this.scale(g.kComplicationHalfHeight),
+		x = this.cx - radius, y = this.cy - radius,
+		complicationSize = small? 14 : 18, dateSize = small? 18 : 24, slotSmallSize = small? 9 : 14,
+		language = previewLanguage(opts["language_picker"], names.kDaysOfWeek.length / 7);
+
+	function twoDigits(n, suppressLeadingZero)
+	{
+		return(((n < 10)? (suppressLeadingZero? " " : "0") : "") + n);
+	}
+
+	function slotText(source)
+	{
+		switch(source)
+		{
+		case kPreviewSourceWeekday:
+			return(option("optionHideWeekday_option")? null : names.kDaysOfWeek[7 * (language - 1) + weekDay]);
+		case kPreviewSourceMonth:
+			return(option("optionHideMonth_option")? null : names.kMonthNames[12 * (language - 1) + month]);
+		case kPreviewSourceDate:
+			return(option("optionHideDate_option")? null : twoDigits(day, option("optionDateLeadingZeroSuppression_option")));
+		case kPreviewSourceBattery:
+			if(option("optionHideBattery_option"))
+				return(null);
+			if(option("optionBatteryTimeRemaining_option"))
+				return((kPreviewHoursRemaining < 100)? (kPreviewHoursRemaining + "h") : (Math.floor(kPreviewHoursRemaining / 24) + "d"));
+			return(kPreviewCharge + "%");
+		case kPreviewSourceSteps:
+			if(!display.health)
+				return("--");
+			return((kPreviewSteps < 10000)? String(kPreviewSteps) : (kPreviewSteps < 100000)?
+				(Math.floor(kPreviewSteps / 1000) + "." + (Math.floor(kPreviewSteps / 100) % 10) + "k") : (Math.floor(kPreviewSteps / 1000) + "k"));
+		case kPreviewSourceHeartRate:
+			return(display.health? (kPreviewHeartRate + "bpm") : "--");
+		case kPreviewSourceSecondZone:
+			// the time in the zone offset from UTC, in the digital time's style
+			var zone = new Date(now.getTime() + (Math.round((parseFloat(opts["secondZoneOffset_picker"]) || 0) * 4) * 15 * 60 * 1000)),
+				zoneHours = zone.getUTCHours();
+			if(option("option12HourTime_option") && (zoneHours > 12))
+				zoneHours -= 12;
+			return(	(option("optionHourLeadingZeroSuppression_option")? String(zoneHours) : twoDigits(zoneHours, false))
+					+ ":" + twoDigits(zone.getUTCMinutes(), false));
+		}
+		return(null);
+	}
+
+	var slots =
+	[
+		{id: "slotTop_picker", color: "complicationDayColor_picker",
+			box: {x: this.cx - w, y: y + midRadius - h, w: 2 * w, h: 2 * h}},
+		{id: "slotLeft_picker", color: "complicationMonthColor_picker",
+			box: {x: x + outerRadius, y: this.cy - h, w: innerRadius - outerRadius, h: 2 * h}},
+		{id: "slotRight_picker", color: "complicationDateColor_picker",
+			box: {x: x + (2 * radius) - innerRadius, y: this.cy - h - g.kDateBoxPadding, w: innerRadius - outerRadius, h: 2 * h + 2 * g.kDateBoxPadding}},
+		{id: "slotBottom_picker", color: "complicationBatteryColor_picker",
+			box: {x: this.cx - w, y: y + (2 * radius) - midRadius - h, w: 2 * w, h: 2 * h}},
+	];
+	for(var s = 0; s < slots.length; s++)
+	{
+		var source = parseInt(opts[slots[s].id], 10) || 0,
+			string = slotText(source);
+		if(string !== null)
+		{
+			// only the date in the right slot takes the larger font
+			this.text(	string, slots[s].box, ((s == 2) && (source == kPreviewSourceDate))? dateSize : complicationSize,
+						color(slots[s].color), slotSmallSize);
+		}
+	}
+
+	// the rings: minutes outside, hours inside, whose colors swap after noon
+	this.ring(radius - outerCircleOuterInset, outerCircleInnerInset, minuteAngle, elapsedOuterColor, elapsedOuterBackground);
+	this.ring(	radius - innerCircleOuterInset, innerCircleInnerInset, hourAngle,
+				pm? elapsedInnerBackground : elapsedInnerColor, pm? elapsedInnerColor : elapsedInnerBackground);
+
+	// the hands, from the innermost circle; the minute hand stops short of the edge of a rectangular screen
+	this.hand(hourAngle, handRadius, radius - hourHandInset, hourHandWidth, color("hourHandColor_picker"));
+	this.hand(minuteAngle, handRadius, display.round? radius : (radius - Math.floor(minuteHandWidth / 2) - 1), minuteHandWidth, color("minuteHandColor_picker"));
+
+	// the innermost circle and the digital time
+	ctx.fillStyle = color("innermostBackgroundColor_picker");
+	ctx.beginPath();
+	ctx.arc(this.cx, this.cy, handRadius, 0, 2 * Math.PI);
+	ctx.fill();
+
+	if(!option("optionHideDigitalTime_option"))
+	{
+		var h12 = (option("option12HourTime_option") && (hours > 12))? (hours - 12) : hours,
+			hourString = ((h12 < 10)? (option("optionHourLeadingZeroSuppression_option")? " " : "0") : "") + h12,
+			minuteString = ((minutes < 10)? "0" : "") + minutes,
+			timeSize = small? 20 : 28;
+		this.text(hourString, {x: this.cx - handRadius, y: this.cy - timeSize, w: 2 * handRadius, h: timeSize}, timeSize, color("innermostTextColor_picker"));
+		this.text(minuteString, {x: this.cx - handRadius, y: this.cy, w: 2 * handRadius, h: timeSize}, timeSize, color("innermostTextColor_picker"));
+	}
+};
+
+// calls back with the text at url, or with null if it can't be had
+function loadText(url, callback)
+{
+	var request = new XMLHttpRequest();
+	request.onload = function() { callback(((request.status == 200) || (request.status == 0))? request.responseText : null); };
+	request.onerror = function() { callback(null); };
+	request.open("GET", url);
+	request.send();
+}
+
+// loads the watchface's geometry and names and calls back with a preview on the canvas, or with
+// null if the headers can't be had (the page opened on its own, say)
+function loadFacePreview(canvas, platform, geometryURL, namesURL, callback)
+{
+	loadText(geometryURL, function(geometryText)
+	{
+		var geometry = parseDefines(geometryText || "");
+		if(!("kDefaultOuterCircleOuterInset" in geometry))
+			return(callback(null));
+
+		loadText(namesURL, function(namesText)
+		{
+			var names = parseStringTables(namesText || "");
+			var days = (names.kDaysOfWeek || []).length, months = (names.kMonthNames || []).length;
+			callback(((days > 0) && ((days % 7) == 0) && (months == (days / 7) * 12))?
+				new FacePreview(canvas, platform, geometry, names) : null);
+		});
+	});
+}
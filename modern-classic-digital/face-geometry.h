@@ -0,0 +1,27 @@
+// The face's default geometry, in pixels of chalk's 180-pixel dial; the watchface scales each
+// length to its own dial with kDialScale.  The configuration page's preview reads this file too,
+// so every definition stays a plain "#define name number" line.
+
+// the minute ring: its distance from the edge of the dial, and its width
+#define kDefaultOuterCircleOuterInset	12
+#define kDefaultOuterCircleInnerInset	8
+
+// the hour ring: its distance inside the minute ring's outer edge, and its width
+#define kDefaultInnerCircleSpacing		40
+#define kDefaultInnerCircleInnerInset	5
+
+// where the hour hand ends, inside the minute ring's outer edge
+#define kDefaultHourHandSpacing			25
+
+#define kDefaultHourHandWidth			7
+#define kDefaultMinuteHandWidth			3
+
+// half the width and height of the day and battery boxes, and the height of the month and
+// date ones, between the rings
+#define kComplicationHalfWidth			20
+#define kComplicationHalfHeight			14
+
+// unscaled: the complication boxes' clearance from the rings, and the date box's extra height
+// above and below for its larger type
+#define kComplicationRingClearance		2
+#define kDateBoxPadding					3
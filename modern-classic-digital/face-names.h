@@ -0,0 +1,32 @@
+// The day and month names the complications show, in each language the watchface has, in the
+// order of its kLanguage* (so kLanguageArabic, 1, is the first row).  The configuration page's
+// preview reads this file too, so each table stays a "static char const* const name[] =" of
+// string literals, with comments only after "//".
+
+static char const* const kDaysOfWeek[] =
+{
+	"د", "ن", "ث", "ع", "خ", "ج", "س",					// kLanguageArabic = 1
+	"SO.", "MO.", "DI.", "MI.", "DO.", "FR.", "SA.",	// kLanguageGerman = 2
+	"SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT",	// kLanguageEnglish = 3
+	"DOM", "LUN", "MAR", "MIE", "JUE", "VIE", "SAB",	// kLanguageSpanish = 4
+	"DIM", "LUN", "MAR", "MER", "JEU", "VEN", "SAM",	// kLanguageFrench = 5
+	"DOM", "LUN", "MAR", "MER", "GIO", "VEN", "SAB",	// kLanguageItalian = 6
+	"ZON", "MAA", "DIN", "WOE", "DON", "VRI", "ZAT", 	// kLanguageDutch = 7
+	"DOM", "SEG", "TER", "QUA", "QUI", "SEX", "SÁB",	// kLanguagePortuguese = 8
+	"ПНД", "ВТР", "СРД", "ЧТВ", "ПТН", "СБТ", "ВСК",	// kLanguageRussian = 9
+	//"VSK", "PND", "VTR", "SRD", "CHT", "PTN", "SBT",	// kLanguageRussian = 9 (Romanized)
+};
+
+static char const* const kMonthNames[] =
+{
+	"ٌناٌر", "فبراٌر", "مارس", "إبرٌل", "ماٌو", "ٌونٌو", "ٌولٌو", "أؼسطس", "سبتمبر", "أكتوبر", "نوفمبر", "دٌسمبر",		// kLanguageArabic = 1	// TODO: Hijri calendar
+	"JÄN", "FEB", "MÄR", "APR", "MAI", "JUN", "JUL", "AUG", "SEP", "OKT", "NOV", "DEZ", 	// kLanguageGerman = 2
+	"JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC",		// kLanguageEnglish = 3
+	"ENE", "FEB", "MAR", "ABR", "MAY", "JUN", "JUL", "AGO", "SEP", "OCT", "NOV", "DIC",		// kLanguageSpanish = 4
+	"JAN", "FÉV", "MAR", "AVR", "MAI", "JUN", "JUL", "AOÛ", "SEP", "OCT", "NOV", "DÉC", 	// kLanguageFrench = 5
+	"GEN", "FEB", "MAR", "APR", "MAG", "GIU", "LUG", "AGO", "SET", "OTT", "NOV", "DIC", 	// kLanguageItalian = 6
+	"JAN", "FEB", "MAR", "APR", "MEI", "JUN", "JUL", "AUG", "SEP", "OKT", "NOV", "DEC",		// kLanguageDutch = 7
+	"JAN", "FEV", "MAR", "ABR", "MAI", "JUN", "JUL", "AGO", "SET", "OUT", "NOV", "DEZ",		// kLanguagePortuguese = 8
+	"янв", "фев", "мар", "апр", "май", "июн", "июл", "авг", "сен", "окт", "ноя", "дек",		// kLanguageRussian = 9
+	//"IAN", "FEV", "MAR", "APR", "MAI", "IUN", "IUL", "AVG", "SEN", "OKT", "NOI", "DEK",	// kLanguageRussian = 9 (Romanized)
+};
@@ -0,0 +1,434 @@
+// Golden frames: renders the face in a fixed set of cases (every language, the options that change
+// what's drawn, a sweep of battery and connection states, and the complication slots bound to
+// other sources), each from a full repaint at a fixed time in UTC, and checks a hash of each frame
+// against the ones checked in under golden/.  Render time is reported per case, the best of a few
+// repaints.  Each case is then launched into cold, and both its first frame, the snapshot where
+// the platform keeps one, and the live one after it must match, but for pixels antialiasing
+// blended (which hash as blended, whatever their color); the snapshot's size and the first
+// frame's time are reported alongside.  No render may write persistent storage, which would stall
+// the frame on the watch.
+//
+//	usage: golden_frames [-u] [-g golden.txt] [-w dir] [-d dir] [-r repeats]
+//
+// -u rewrites the golden file from this build instead of checking it.
+//
+// -w saves each case's frame as dir/<case>.ppm, and the render times as dir/times.txt; -d then
+// compares the frames of another build with those pixel by pixel, and its render times with
+// those, so a rewrite of the drawing can be shown to draw the same and to draw it faster.
+//
+// The watchface source is included directly so its option and language names are reachable.
+
+#include "host.h"
+
+#define main pebbleMain
+#include "../modern-classic-digital.c"
+#undef main
+
+#include <stdlib.h>
+
+#if defined(PBL_PLATFORM_APLITE)
+#define kPlatformName "aplite"
+#elif defined(PBL_PLATFORM_BASALT)
+#define kPlatformName "basalt"
+#elif defined(PBL_PLATFORM_DIORITE)
+#define kPlatformName "diorite"
+#elif defined(PBL_PLATFORM_EMERY)
+#define kPlatformName "emery"
+#else
+#define kPlatformName "chalk"
+#endif
+
+enum { kMaxCases = 64, kCaseNameSize = 48 };
+
+typedef struct GoldenCase
+{
+	char const*	name;
+	uint32_t	options;		// kOption*s
+	uint8_t		language;		// kLanguage*
+	char const*	locale;			// the watch's, for kLanguageAutomatic
+	uint8_t		hour, minute;	// on Friday 4 March 2016
+	uint8_t		charge;			// percent
+	bool		charging, plugged;
+	uint8_t		drainHours;		// the charge was 10% higher this long before, when set
+	bool		disconnected;
+	uint32_t	slots;			// gTimeState.complications
+	int32_t		steps,			// what HealthService reports; negative if it has nothing
+				heartRate;
+} GoldenCase;
+
+#define SLOTS(top, left, right, bottom) ((top) | ((left) << 4) | ((right) << 8) | ((bottom) << 12))
+
+// a morning with the date and hour under 10, most of a charge left, the phone in reach and the
+// default slots, unless a case says otherwise
+#define CASE(caseName, ...) \
+	{	.name = caseName, .language = kLanguageEnglish, .locale = "en_US", .hour = 9, .minute = 41, .charge = 70, \
+		.slots = kSlotsDefault, .steps = -1, .heartRate = -1, __VA_ARGS__	}
+
+static GoldenCase const kCases[] =
+{
+	CASE("language-ar", .language = kLanguageArabic),
+	CASE("language-de", .language = kLanguageGerman),
+	CASE("language-en"),
+	CASE("language-es", .language = kLanguageSpanish),
+	CASE("language-fr", .language = kLanguageFrench),
+	CASE("language-it", .language = kLanguageItalian),
+	CASE("language-nl", .language = kLanguageDutch),
+	CASE("language-pt", .language = kLanguagePortuguese),
+	CASE("language-ru", .language = kLanguageRussian),
+	CASE("language-auto-de", .language = kLanguageAutomatic, .locale = "de_DE"),
+
+	CASE("afternoon", .hour = 13, .minute = 5),
+	CASE("midnight", .hour = 0, .minute = 0),
+	CASE("before-midnight", .hour = 23, .minute = 59),
+	CASE("12-hour", .options = kOption12HourTime, .hour = 13, .minute = 5),
+	CASE("12-hour-no-leading-zero", .options = kOption12HourTime | kOptionHourLeadingZeroSuppression, .hour = 13, .minute = 5),
+	CASE("hour-no-leading-zero", .options = kOptionHourLeadingZeroSuppression),
+	CASE("date-no-leading-zero", .options = kOptionDateLeadingZeroSuppression),
+	CASE("hour-hand-snap", .options = kOptionHourHandSnap),
+	CASE("demo", .options = kOptionDemoMode),
+	CASE("hide-weekday", .options = kOptionHideWeekday),
+	CASE("hide-month", .options = kOptionHideMonth),
+	CASE("hide-date", .options = kOptionHideDate),
+	CASE("hide-battery", .options = kOptionHideBattery),
+	CASE("hide-complications", .options = kOptionHideWeekday | kOptionHideMonth | kOptionHideDate | kOptionHideBattery),
+	CASE("hide-digital-time", .options = kOptionHideDigitalTime),
+	CASE("battery-time-remaining", .options = kOptionBatteryTimeRemaining, .drainHours = 5),
+	CASE("battery-days-remaining", .options = kOptionBatteryTimeRemaining, .charge = 90, .drainHours = 40),
+
+	CASE("battery-full", .charge = 100),
+	CASE("battery-low", .charge = 20),
+	CASE("battery-critical", .charge = 5),
+	CASE("battery-charging", .charge = 40, .charging = true, .plugged = true),
+	CASE("battery-plugged", .charge = 100, .plugged = true),
+	CASE("connection-lost", .disconnected = true),
+	CASE("connection-lost-hidden", .options = kOptionHideConnectionLost, .disconnected = true),
+	CASE("connection-lost-battery-critical", .charge = 5, .disconnected = true),
+
+	CASE("slots-rearranged", .slots = SLOTS(kSourceDate, kSourceBattery, kSourceWeekday, kSourceMonth)),
+	CASE("slots-empty", .slots = SLOTS(kSourceNone, kSourceNone, kSourceNone, kSourceNone)),
+	CASE(	"slots-health", .slots = SLOTS(kSourceHeartRate, kSourceMonth, kSourceDate, kSourceSteps),
+			.steps = 12480, .heartRate = 64	),
+	CASE("slots-health-unavailable", .slots = SLOTS(kSourceHeartRate, kSourceMonth, kSourceDate, kSourceSteps)),
+	CASE("slots-second-zone", .slots = SLOTS(kSourceSecondZone, kSourceMonth, kSourceDate, kSourceBattery) | (22 << 16)),
+	CASE(	"slots-second-zone-12-hour", .options = kOption12HourTime | kOptionHourLeadingZeroSuppression,
+			.slots = SLOTS(kSourceSecondZone, kSourceMonth, kSourceDate, kSourceBattery) | ((uint8_t)-20 << 16)	),
+};
+
+typedef struct GoldenEntry
+{
+	char		name[kCaseNameSize];
+	double		value;	// a hash, or microseconds
+} GoldenEntry;
+
+// reads "name value" lines, skipping # comments; hashes are hexadecimal
+static uint32_t readEntries(char const* path, GoldenEntry* entries, bool hex)
+{
+	FILE* f = fopen(path, "r");
+	if(f == 0)
+		return(0);
+
+	uint32_t count = 0;
+	char line[128];
+	while((count < kMaxCases) && (fgets(line, sizeof(line), f) != 0))
+	{
+		unsigned int hash;
+		if(line[0] == '#')
+			continue;
+		if(hex && (sscanf(line, "%47s %x", entries[count].name, &hash) == 2))
+			entries[count++].value = hash;
+		else if(!hex && (sscanf(line, "%47s %lf", entries[count].name, &entries[count].value) == 2))
+			count++;
+	}
+	fclose(f);
+	return(count);
+}
+
+static GoldenEntry const* findEntry(GoldenEntry const* entries, uint32_t count, char const* name)
+{
+	for(uint32_t i = 0; i < count; i++)
+		if(strcmp(entries[i].name, name) == 0)
+			return(&entries[i]);
+	return(0);
+}
+
+// renders as hostRenderFrame does, counting the persist writes made during the render
+static uint32_t gRenderPersistWrites = 0;
+
+static bool renderFrame(HostFrameStats* stats)
+{
+	uint32_t writes = hostPersistWriteCount();
+	bool rendered = hostRenderFrame(stats);
+	gRenderPersistWrites += hostPersistWriteCount() - writes;
+	return(rendered);
+}
+
+// a frame and which of its pixels antialiasing blended, whose colors depend on what the frame was
+// drawn over
+typedef struct Frame
+{
+	uint8_t		pixels[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+	bool		blended[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+} Frame;
+
+static void copyFrame(Frame* frame)
+{
+	memcpy(frame->pixels, hostFrameBuffer(), sizeof(frame->pixels));
+	memcpy(frame->blended, hostBlendedPixels(), sizeof(frame->blended));
+}
+
+// FNV-1a over the whole framebuffer, taking only that a blended pixel was blended
+static uint32_t frameHash(void)
+{
+	uint32_t hash = 2166136261u;
+	uint8_t const* pixels = hostFrameBuffer();
+	bool const* blended = hostBlendedPixels();
+	for(size_t p = 0; p < HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT; p++)
+		hash = (hash ^ (blended[p]? 0 : pixels[p])) * 16777619u;
+	return(hash);
+}
+
+// the pixels that differ between two frames, but for those either blended
+static uint32_t framesDiffer(Frame const* a, Frame const* b)
+{
+	uint32_t differing = 0;
+	for(size_t p = 0; p < HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT; p++)
+		differing += (a->pixels[p] != b->pixels[p]) && !a->blended[p] && !b->blended[p];
+	return(differing);
+}
+
+static void setTime(GoldenCase const* c, int hoursBefore)
+{
+	struct tm now = {.tm_year = 116, .tm_mon = 2, .tm_mday = 4, .tm_hour = c->hour - hoursBefore, .tm_min = c->minute, .tm_isdst = -1};
+	mktime(&now);
+	hostSetTime(&now);
+}
+
+// brings the face into the case's state the way the watch would: the configuration through an
+// app message, then the battery and connection through their services
+static void enterCase(GoldenCase const* c)
+{
+	// the connection back, and the battery history reset by a charge
+	hostSetConnection(true);
+	setTime(c, c->drainHours);
+	hostSetBattery((BatteryChargeState){.charge_percent = 100, .is_charging = true, .is_plugged = true});
+
+	// no connection delay, so a drop shows at once
+	uint32_t	flags = c->options | ((uint32_t)gTimeState.hourHandWidth << 16) | ((uint32_t)gTimeState.minuteHandWidth << 24),
+				flags2 = c->language | (kSecondsBurstDefault << 8);
+	uint8_t const config[] =
+	{
+		kConfigVersion,
+		KEY_FLAGS, flags & 0xFF, (flags >> 8) & 0xFF, (flags >> 16) & 0xFF, flags >> 24,
+		KEY_FLAGS2, flags2 & 0xFF, (flags2 >> 8) & 0xFF, (flags2 >> 16) & 0xFF, flags2 >> 24,
+		KEY_COMPLICATIONS, c->slots & 0xFF, (c->slots >> 8) & 0xFF, (c->slots >> 16) & 0xFF, c->slots >> 24,
+	};
+	hostSetHealth(HealthMetricStepCount, c->steps);
+	hostSetHealth(HealthMetricHeartRateBPM, c->heartRate);
+	hostSetLocale(c->locale);
+	hostReceiveAppMessage(KEY_CONFIG, config, sizeof(config));
+
+	if(c->drainHours > 0)
+	{
+		hostSetBattery((BatteryChargeState){.charge_percent = c->charge + 10});
+		setTime(c, 0);
+	}
+	hostSetBattery((BatteryChargeState){.charge_percent = c->charge, .is_charging = c->charging, .is_plugged = c->plugged});
+	if(c->disconnected)
+		hostSetConnection(false);
+}
+
+int main(int argc, char** argv)
+{
+	char const* goldenPath = "golden/" kPlatformName ".txt";
+	char const* saveDir = 0;
+	char const* compareDir = 0;
+	bool update = false;
+	int repeats = 5;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-u") == 0)
+			update = true;
+		else if((strcmp(argv[i], "-g") == 0) && (i + 1 < argc))
+			goldenPath = argv[++i];
+		else if((strcmp(argv[i], "-w") == 0) && (i + 1 < argc))
+			saveDir = argv[++i];
+		else if((strcmp(argv[i], "-d") == 0) && (i + 1 < argc))
+			compareDir = argv[++i];
+		else if((strcmp(argv[i], "-r") == 0) && (i + 1 < argc) && (atoi(argv[i + 1]) > 0))
+			repeats = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: %s [-u] [-g golden.txt] [-w dir] [-d dir] [-r repeats]\n", argv[0]);
+			return(1);
+		}
+	}
+
+	static GoldenEntry golden[kMaxCases], referenceTimes[kMaxCases];
+	uint32_t goldenCount = update? 0 : readEntries(goldenPath, golden, true), referenceTimeCount = 0;
+	char path[256];
+	if(compareDir != 0)
+	{
+		snprintf(path, sizeof(path), "%s/times.txt", compareDir);
+		referenceTimeCount = readEntries(path, referenceTimes, false);
+	}
+
+	FILE* goldenFile = 0;
+	FILE* timesFile = 0;
+	if(update && ((goldenFile = fopen(goldenPath, "w")) == 0))
+	{
+		fprintf(stderr, "%s: can't write %s\n", argv[0], goldenPath);
+		return(1);
+	}
+	if(saveDir != 0)
+	{
+		snprintf(path, sizeof(path), "%s/times.txt", saveDir);
+		if((timesFile = fopen(path, "w")) == 0)
+		{
+			fprintf(stderr, "%s: can't write %s\n", argv[0], path);
+			return(1);
+		}
+	}
+	if(goldenFile != 0)
+		fprintf(goldenFile, "# golden_frames, %s: case, hash of its frame (make golden rewrites this)\n", kPlatformName);
+
+	// the second time zone is an offset from UTC: take the watch to be on it too
+	setenv("TZ", "UTC", 1);
+	tzset();
+	// and boot at a fixed time: antialiased edges blend with whatever the frames before them drew
+	setTime(&kCases[0], 0);
+	pebbleMain();
+	hostRenderFrame(0);
+	while(hostStepAnimations(33))	// the opening sweep; the frames are of the face at rest
+		hostRenderFrame(0);
+
+	uint32_t caseCount = sizeof(kCases) / sizeof(kCases[0]), failures = 0;
+	double totalMicroseconds = 0, totalReferenceMicroseconds = 0, totalFirstMicroseconds = 0;
+#if defined(PBL_COLOR)
+	uint32_t largestSnapshot = 0;
+#endif
+	for(uint32_t i = 0; i < caseCount; i++)
+	{
+		GoldenCase const* c = &kCases[i];
+		enterCase(c);
+		gRenderPersistWrites = 0;
+
+		// the best of a few full repaints, so the time says what the drawing costs
+		uint64_t nanoseconds = UINT64_MAX;
+		for(int r = 0; r < repeats; r++)
+		{
+			HostFrameStats frame;
+			hostRedisplayWindow();
+			renderFrame(&frame);
+			if(frame.renderNanoseconds < nanoseconds)
+				nanoseconds = frame.renderNanoseconds;
+		}
+		double microseconds = nanoseconds / 1000.0;
+		totalMicroseconds += microseconds;
+
+		static Frame repainted, firstFrame, liveFrame;
+		uint32_t hash = frameHash();
+		copyFrame(&repainted);
+		printf("  %-34s %08x %8.1f us", c->name, hash, microseconds);
+
+		// the cold start: the appear work waits for a timer, which the time being set again fires
+		HostFrameStats first;
+		hostRelaunch();
+		renderFrame(&first);
+		copyFrame(&firstFrame);
+		setTime(c, 0);
+		bool drewLive = renderFrame(0);
+		copyFrame(&liveFrame);
+#if !defined(PBL_COLOR)
+		drewLive = true;	// without a snapshot, the first frame was the live one
+#endif
+		totalFirstMicroseconds += first.renderNanoseconds / 1000.0;
+#if defined(PBL_COLOR)
+		printf(", snapshot %4u bytes, first frame %6.1f us", gSnapshot.size, first.renderNanoseconds / 1000.0);
+		if(gSnapshot.size > largestSnapshot)
+			largestSnapshot = gSnapshot.size;
+#endif
+		if(!drewLive)
+		{
+			printf("  cold start draws no live frame");
+			failures++;
+		}
+		else if(gRenderPersistWrites > 0)
+		{
+			printf("  %u persist writes while rendering", (unsigned int)gRenderPersistWrites);
+			failures++;
+		}
+		else if((framesDiffer(&firstFrame, &repainted) > 0) || (framesDiffer(&liveFrame, &repainted) > 0))
+		{
+			printf(	"  cold start draws %u then %u pixels otherwise", framesDiffer(&firstFrame, &repainted),
+					framesDiffer(&liveFrame, &repainted)
+				);
+			failures++;
+		}
+
+		GoldenEntry const* expected = findEntry(golden, goldenCount, c->name);
+		if(goldenFile != 0)
+			fprintf(goldenFile, "%s %08x\n", c->name, hash);
+		else if(expected == 0)
+		{
+			printf("  not in %s", goldenPath);
+			failures++;
+		}
+		else if((uint32_t)expected->value != hash)
+		{
+			printf("  differs from %08x", (uint32_t)expected->value);
+			failures++;
+		}
+
+		if(saveDir != 0)
+		{
+			snprintf(path, sizeof(path), "%s/%s.ppm", saveDir, c->name);
+			hostWriteFrameBuffer(path);
+			fprintf(timesFile, "%s %.1f\n", c->name, microseconds);
+		}
+		if(compareDir != 0)
+		{
+			GRect differing;
+			snprintf(path, sizeof(path), "%s/%s.ppm", compareDir, c->name);
+			uint32_t pixels = hostCompareFrameBuffer(path, &differing);
+			if(pixels == UINT32_MAX)
+				printf(", no %s", path);
+			else if(pixels > 0)
+			{
+				failures++;
+				printf(	", %u pixels differ in %dx%d at (%d, %d)", pixels,
+						differing.size.w, differing.size.h, differing.origin.x, differing.origin.y
+					);
+			}
+
+			GoldenEntry const* reference = findEntry(referenceTimes, referenceTimeCount, c->name);
+			if(reference != 0)
+			{
+				printf(", was %.1f us", reference->value);
+				totalReferenceMicroseconds += reference->value;
+			}
+		}
+		printf("\n");
+	}
+
+	printf("%u cases, %.1f us rendering", caseCount, totalMicroseconds);
+	if(totalReferenceMicroseconds > 0)
+		printf(" (%.1f us before, %.2fx)", totalReferenceMicroseconds, totalReferenceMicroseconds / totalMicroseconds);
+	printf("\n");
+#if defined(PBL_COLOR)
+	printf(	"snapshots: the largest %u of %u bytes; first frames %.1f us, %.2fx rendering\n", largestSnapshot,
+			kSnapshotKeys * PERSIST_DATA_MAX_LENGTH, totalFirstMicroseconds, totalFirstMicroseconds / totalMicroseconds
+		);
+#endif
+
+	if(timesFile != 0)
+		fclose(timesFile);
+	if(goldenFile != 0)
+	{
+		fclose(goldenFile);
+		printf("wrote %s\n", goldenPath);
+		return(0);
+	}
+	printf("%u of %u frames differ from the golden ones\n", failures, caseCount);
+	return((failures > 0)? 1 : 0);
+}
@@ -0,0 +1,99 @@
+// Host-side controls for the stand-in Pebble SDK: drive the event services, render frames
+// into the software framebuffer and read back per-layer render statistics.
+
+#ifndef PEBBLE_HOST_HOST_H
+#define PEBBLE_HOST_HOST_H
+
+#include "pebble.h"
+
+// the display of the platform being built (see pebble.h), always 8-bit ARGB here
+#define HOST_SCREEN_WIDTH	PBL_DISPLAY_WIDTH
+#define HOST_SCREEN_HEIGHT	PBL_DISPLAY_HEIGHT
+#define HOST_MAX_LAYERS		8
+
+typedef struct HostDrawStats
+{
+	uint32_t	pixelsWritten,	// framebuffer writes, including overwrites of the same pixel (direct
+								// framebuffer access counts only the pixels it changed)
+				drawCalls,		// graphics_fill_* / graphics_draw_* calls
+				textLayouts,	// graphics_draw_text / graphics_text_layout_get_content_size calls
+				trigLookups;	// sin_lookup / cos_lookup / atan2_lookup / gpoint_from_polar calls
+} HostDrawStats;
+
+typedef struct HostLayerStats
+{
+	Layer const*	layer;
+	uint64_t		renderNanoseconds;
+	uint32_t		stackBytes;		// below the update proc's caller, including the stand-in SDK's calls
+	HostDrawStats	draw;
+} HostLayerStats;
+
+typedef struct HostFrameStats
+{
+	uint64_t		renderNanoseconds;
+	HostDrawStats	draw;			// totals for the frame, including the window background
+	uint32_t		pixelsCovered;	// distinct pixels written; draw.pixelsWritten / pixelsCovered is the overdraw
+	uint32_t		antialiasingOverwritten;	// antialiased edges written over straight into the
+												// framebuffer, with antialiasing on, and left that way
+	uint32_t		layerCount;
+	HostLayerStats	layers[HOST_MAX_LAYERS];	// in render (back-to-front) order
+} HostFrameStats;
+
+// the watchface's main(), renamed at compile time so the harness can own main()
+int pebbleMain(void);
+
+// renders the top window if any layer has been marked dirty since the last frame
+bool hostRenderFrame(HostFrameStats* stats);
+uint8_t const* hostFrameBuffer(void);	// HOST_SCREEN_HEIGHT rows of HOST_SCREEN_WIDTH ARGB8 pixels
+bool const* hostBlendedPixels(void);	// likewise, whether an antialiased edge last wrote each pixel
+// while refusing, graphics_capture_frame_buffer returns nothing to a context with antialiasing
+// on, so whatever the watchface would write straight into the framebuffer it draws through the SDK
+void hostRefuseAntialiasedCapture(bool refuse);
+bool hostWriteFrameBuffer(char const* ppmPath);
+// the pixels that differ from a frame hostWriteFrameBuffer saved, and the rectangle bounding them;
+// UINT32_MAX if the file can't be read or is another size
+uint32_t hostCompareFrameBuffer(char const* ppmPath, GRect* differing);
+
+// event sources; hostSetTime delivers a tick only when a subscribed unit changed
+void hostSetTime(struct tm const* now);
+// lets milliseconds pass without a tick, firing the app timers due by then; hostSetTime starts
+// the count over at its second
+void hostRunTimers(uint32_t milliseconds);
+void hostSetBattery(BatteryChargeState charge);
+void hostSetConnection(bool connected);
+// what HealthService reports for the metric (today's total, or the latest reading); negative
+// makes it unavailable, as it is until it's set
+void hostSetHealth(HealthMetric metric, HealthValue value);
+void hostSetLocale(char const* locale);
+void hostTap(AccelAxisType axis, int32_t direction);
+// advances the scheduled animations by milliseconds, updating each and stopping those that reach
+// their ends; returns whether any are still running
+bool hostStepAnimations(uint32_t milliseconds);
+// the top window disappears and appears again, as when another window covered it, and is redrawn
+void hostRedisplayWindow(void);
+// quits the watchface the way the system would and launches it again: its window unloads, its
+// timers, animations and subscriptions go, the framebuffer is blanked and pebbleMain runs again.
+// Persistent storage is kept, and so, unlike on the watch, are the face's statics.
+void hostRelaunch(void);
+// delivers a one-tuple dictionary to the inbox, or drops it if it doesn't fit the opened inbox
+void hostReceiveAppMessage(uint32_t key, uint8_t const* data, uint16_t length);
+
+// counters for the side effects the watchface has on the device
+uint32_t hostVibrationCount(void);
+uint32_t hostPersistWriteCount(void);
+uint32_t hostTickCount(void);	// tick handler calls, each of which woke the watch
+
+// the heap the watchface has allocated through the SDK, now and at its peak, by what it's for
+typedef struct HostHeapStats
+{
+	uint32_t	bytes, peakBytes;
+	uint32_t	layerBytes, peakLayerBytes;				// windows, layers and animations
+	uint32_t	bitmapBytes, peakBitmapBytes;
+	uint32_t	appMessageBytes, peakAppMessageBytes;	// inbox and outbox
+} HostHeapStats;
+
+HostHeapStats hostHeapStats(void);
+
+uint64_t hostNanoseconds(void);
+
+#endif // PEBBLE_HOST_HOST_H
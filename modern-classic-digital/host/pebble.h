@@ -0,0 +1,406 @@
+// Stand-in for the Pebble SDK's pebble.h, sufficient to build the watchface on a Linux host.
+// Only the parts of the SDK that the watchface uses are declared here; semantics follow the
+// SDK documentation closely enough for render measurements, not for pixel-exact emulation.
+
+#ifndef PEBBLE_HOST_PEBBLE_H
+#define PEBBLE_HOST_PEBBLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// platform, as the SDK's build defines it; chalk unless one is given (-DPBL_PLATFORM_BASALT etc.)
+
+#if defined(PBL_PLATFORM_APLITE) || defined(PBL_PLATFORM_DIORITE)
+#define PBL_RECT
+#define PBL_BW
+#define PBL_DISPLAY_WIDTH	144
+#define PBL_DISPLAY_HEIGHT	168
+#elif defined(PBL_PLATFORM_BASALT)
+#define PBL_RECT
+#define PBL_COLOR
+#define PBL_DISPLAY_WIDTH	144
+#define PBL_DISPLAY_HEIGHT	168
+#elif defined(PBL_PLATFORM_EMERY)
+#define PBL_RECT
+#define PBL_COLOR
+#define PBL_DISPLAY_WIDTH	200
+#define PBL_DISPLAY_HEIGHT	228
+#else
+#if !defined(PBL_PLATFORM_CHALK)
+#define PBL_PLATFORM_CHALK
+#endif
+#define PBL_ROUND
+#define PBL_COLOR
+#define PBL_DISPLAY_WIDTH	180
+#define PBL_DISPLAY_HEIGHT	180
+#endif
+
+// every platform but aplite has HealthService
+#if !defined(PBL_PLATFORM_APLITE)
+#define PBL_HEALTH
+#endif
+
+// geometry
+
+typedef struct GPoint { int16_t x, y; } GPoint;
+typedef struct GSize { int16_t w, h; } GSize;
+typedef struct GRect { GPoint origin; GSize size; } GRect;
+
+#define GPoint(x, y)		((GPoint){(x), (y)})
+#define GSize(w, h)			((GSize){(w), (h)})
+#define GRect(x, y, w, h)	((GRect){{(x), (y)}, {(w), (h)}})
+#define GPointZero			GPoint(0, 0)
+#define GRectZero			GRect(0, 0, 0, 0)
+
+// colors (64-color ARGB8)
+
+typedef union GColor8
+{
+	uint8_t argb;
+	struct
+	{
+		uint8_t b:2;
+		uint8_t g:2;
+		uint8_t r:2;
+		uint8_t a:2;
+	};
+} GColor8;
+typedef GColor8 GColor;
+
+#define GColorARGB8(a, r, g, b)		((GColor8){.argb = (uint8_t)(((a) << 6) | ((r) << 4) | ((g) << 2) | (b))})
+#define GColorFromRGB(r, g, b)		GColorARGB8(3, ((r) >> 6) & 3, ((g) >> 6) & 3, ((b) >> 6) & 3)
+#define GColorFromHEX(v)			GColorFromRGB((((v) >> 16) & 0xFF), (((v) >> 8) & 0xFF), ((v) & 0xFF))
+#define gcolor_equal(a, b)			((a).argb == (b).argb)
+
+#define GColorClear					((GColor8){.argb = 0x00})
+#define GColorBlack					GColorARGB8(3, 0, 0, 0)
+#define GColorDarkGray				GColorARGB8(3, 1, 1, 1)
+#define GColorLightGray				GColorARGB8(3, 2, 2, 2)
+#define GColorWhite					GColorARGB8(3, 3, 3, 3)
+#define GColorBlue					GColorARGB8(3, 0, 0, 3)
+#define GColorRed					GColorARGB8(3, 3, 0, 0)
+#define GColorGreen					GColorARGB8(3, 0, 3, 0)
+#define GColorDarkCandyAppleRed		GColorARGB8(3, 2, 0, 0)
+#define GColorOxfordBlue			GColorARGB8(3, 0, 0, 1)
+#define GColorIslamicGreen			GColorARGB8(3, 0, 2, 0)
+#define GColorChromeYellow			GColorARGB8(3, 3, 2, 0)
+
+// trigonometry
+
+#define TRIG_MAX_RATIO				0xffff
+#define TRIG_MAX_ANGLE				0x10000
+#define DEG_TO_TRIGANGLE(angle)		(((angle) * TRIG_MAX_ANGLE) / 360)
+#define TRIGANGLE_TO_DEG(angle)		(((angle) * 360) / TRIG_MAX_ANGLE)
+
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+int32_t atan2_lookup(int16_t y, int16_t x);
+
+// graphics
+
+typedef struct GContext GContext;
+typedef struct GFont* GFont;
+typedef struct GTextAttributes GTextAttributes;
+
+typedef enum { GOvalScaleModeFitCircle, GOvalScaleModeFillCircle } GOvalScaleMode;
+typedef enum { GTextOverflowModeWordWrap, GTextOverflowModeTrailingEllipsis, GTextOverflowModeFill } GTextOverflowMode;
+typedef enum { GTextAlignmentLeft, GTextAlignmentCenter, GTextAlignmentRight } GTextAlignment;
+
+#define FONT_KEY_GOTHIC_09					"RESOURCE_ID_GOTHIC_09"
+#define FONT_KEY_GOTHIC_14					"RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_18					"RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_24					"RESOURCE_ID_GOTHIC_24"
+#define FONT_KEY_LECO_20_BOLD_NUMBERS		"RESOURCE_ID_LECO_20_BOLD_NUMBERS"
+#define FONT_KEY_LECO_28_LIGHT_NUMBERS		"RESOURCE_ID_LECO_28_LIGHT_NUMBERS"
+
+GFont fonts_get_system_font(char const* fontKey);
+
+void graphics_context_set_fill_color(GContext* context, GColor color);
+void graphics_context_set_stroke_color(GContext* context, GColor color);
+void graphics_context_set_stroke_width(GContext* context, uint8_t width);
+void graphics_context_set_text_color(GContext* context, GColor color);
+void graphics_context_set_antialiased(GContext* context, bool enable);
+
+typedef enum { GCornerNone = 0, GCornersAll = 15 } GCornerMask;
+void graphics_fill_rect(GContext* context, GRect rect, uint16_t cornerRadius, GCornerMask cornerMask);
+void graphics_fill_circle(GContext* context, GPoint center, uint16_t radius);
+void graphics_fill_radial(GContext* context, GRect rect, GOvalScaleMode scaleMode, uint16_t insetThickness, int32_t angleStart, int32_t angleEnd);
+void graphics_draw_line(GContext* context, GPoint p0, GPoint p1);
+void graphics_draw_text(GContext* context, char const* text, GFont const font, GRect const box, GTextOverflowMode const overflowMode, GTextAlignment const alignment, GTextAttributes* const textAttributes);
+GSize graphics_text_layout_get_content_size(char const* text, GFont const font, GRect const box, GTextOverflowMode const overflowMode, GTextAlignment const alignment);
+
+GPoint gpoint_from_polar(GRect rect, GOvalScaleMode scaleMode, int32_t angle);
+
+// bitmaps and direct framebuffer access
+
+typedef struct GBitmap GBitmap;
+
+typedef enum
+{
+	GBitmapFormat1Bit = 0,
+	GBitmapFormat8Bit = 1,
+	GBitmapFormat1BitPalette = 2,
+	GBitmapFormat2BitPalette = 3,
+	GBitmapFormat4BitPalette = 4,
+	GBitmapFormat8BitCircular = 5,
+} GBitmapFormat;
+
+typedef struct GBitmapDataRowInfo
+{
+	uint8_t*	data;	// indexed by absolute x
+	int16_t		min_x;
+	int16_t		max_x;
+} GBitmapDataRowInfo;
+
+typedef enum { GCompOpAssign, GCompOpAssignInverted, GCompOpOr, GCompOpAnd, GCompOpClear, GCompOpSet } GCompOp;
+
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format);
+void gbitmap_destroy(GBitmap* bitmap);
+uint8_t* gbitmap_get_data(GBitmap const* bitmap);
+uint16_t gbitmap_get_bytes_per_row(GBitmap const* bitmap);
+GRect gbitmap_get_bounds(GBitmap const* bitmap);
+GBitmapFormat gbitmap_get_format(GBitmap const* bitmap);
+GBitmapDataRowInfo gbitmap_get_data_row_info(GBitmap const* bitmap, uint16_t y);
+
+void graphics_context_set_compositing_mode(GContext* context, GCompOp mode);
+void graphics_draw_bitmap_in_rect(GContext* context, GBitmap const* bitmap, GRect rect);
+
+GBitmap* graphics_capture_frame_buffer(GContext* context);
+bool graphics_release_frame_buffer(GContext* context, GBitmap* buffer);
+
+// windows and layers
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+
+typedef void (*LayerUpdateProc)(struct Layer* layer, GContext* context);
+typedef void (*WindowHandler)(Window* window);
+
+typedef struct WindowHandlers
+{
+	WindowHandler load;
+	WindowHandler appear;
+	WindowHandler disappear;
+	WindowHandler unload;
+} WindowHandlers;
+
+Window* window_create(void);
+void window_destroy(Window* window);
+void window_set_window_handlers(Window* window, WindowHandlers handlers);
+void window_set_background_color(Window* window, GColor color);
+Layer* window_get_root_layer(Window const* window);
+void window_stack_push(Window* window, bool animated);
+
+Layer* layer_create(GRect frame);
+void layer_destroy(Layer* layer);
+void layer_add_child(Layer* parent, Layer* child);
+void layer_set_update_proc(Layer* layer, LayerUpdateProc updateProc);
+GRect layer_get_bounds(Layer const* layer);
+GRect layer_get_frame(Layer const* layer);
+void layer_mark_dirty(Layer* layer);
+
+// event services
+
+uint16_t time_ms(time_t* seconds, uint16_t* milliseconds);	// wall clock, to the millisecond
+
+// the watchface's time(): the simulated clock once hostSetTime has set it, so it agrees with the
+// ticks delivered
+time_t hostTime(time_t* seconds);
+#define time(seconds)	hostTime(seconds)
+
+typedef enum
+{
+	SECOND_UNIT = (1 << 0),
+	MINUTE_UNIT = (1 << 1),
+	HOUR_UNIT = (1 << 2),
+	DAY_UNIT = (1 << 3),
+	MONTH_UNIT = (1 << 4),
+	YEAR_UNIT = (1 << 5),
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm* tickTime, TimeUnits unitsChanged);
+void tick_timer_service_subscribe(TimeUnits tickUnits, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef enum { ACCEL_AXIS_X = 0, ACCEL_AXIS_Y = 1, ACCEL_AXIS_Z = 2 } AccelAxisType;
+typedef void (*AccelTapHandler)(AccelAxisType axis, int32_t direction);
+void accel_tap_service_subscribe(AccelTapHandler handler);
+void accel_tap_service_unsubscribe(void);
+
+typedef struct BatteryChargeState
+{
+	uint8_t charge_percent;
+	bool is_charging;
+	bool is_plugged;
+} BatteryChargeState;
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+BatteryChargeState battery_state_service_peek(void);
+
+typedef void (*ConnectionHandler)(bool connected);
+typedef struct ConnectionHandlers
+{
+	ConnectionHandler pebble_app_connection_handler;
+	ConnectionHandler pebblekit_connection_handler;
+} ConnectionHandlers;
+void connection_service_subscribe(ConnectionHandlers handlers);
+void connection_service_unsubscribe(void);
+bool connection_service_peek_pebble_app_connection(void);
+
+// health values come from hostSetHealth; a metric that hasn't been set isn't available
+typedef int32_t HealthValue;
+typedef enum
+{
+	HealthMetricStepCount,
+	HealthMetricActiveSeconds,
+	HealthMetricWalkedDistanceMeters,
+	HealthMetricSleepSeconds,
+	HealthMetricSleepRestfulSeconds,
+	HealthMetricRestingKCalories,
+	HealthMetricActiveKCalories,
+	HealthMetricHeartRateBPM,
+	HealthMetricCount,		// the stand-in's own, for its table
+} HealthMetric;
+typedef enum
+{
+	HealthServiceAccessibilityMaskAvailable = (1 << 0),
+	HealthServiceAccessibilityMaskNoPermission = (1 << 1),
+	HealthServiceAccessibilityMaskNotSupported = (1 << 2),
+} HealthServiceAccessibilityMask;
+HealthServiceAccessibilityMask health_service_metric_accessible(HealthMetric metric, time_t time_start, time_t time_end);
+HealthValue health_service_sum_today(HealthMetric metric);
+HealthValue health_service_peek_current_value(HealthMetric metric);
+time_t time_start_of_today(void);
+
+void vibes_short_pulse(void);
+void vibes_double_pulse(void);
+
+// timers run on the simulated clock: they fire when hostSetTime passes them
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void* data);
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data);
+void app_timer_cancel(AppTimer* timer);
+
+// animations run when the harness steps them (hostStepAnimations), every curve as linear; like
+// the SDK's, they're destroyed once they stop
+typedef struct Animation Animation;
+typedef uint32_t AnimationProgress;
+#define ANIMATION_NORMALIZED_MAX	65535
+
+typedef enum { AnimationCurveLinear, AnimationCurveEaseIn, AnimationCurveEaseOut, AnimationCurveEaseInOut } AnimationCurve;
+
+typedef struct AnimationImplementation
+{
+	void	(*setup)(Animation* animation);
+	void	(*update)(Animation* animation, AnimationProgress const progress);
+	void	(*teardown)(Animation* animation);
+} AnimationImplementation;
+
+typedef struct AnimationHandlers
+{
+	void	(*started)(Animation* animation, void* context);
+	void	(*stopped)(Animation* animation, bool finished, void* context);
+} AnimationHandlers;
+
+Animation* animation_create(void);
+bool animation_destroy(Animation* animation);
+bool animation_set_duration(Animation* animation, uint32_t duration_ms);
+bool animation_set_curve(Animation* animation, AnimationCurve curve);
+bool animation_set_implementation(Animation* animation, AnimationImplementation const* implementation);
+bool animation_set_handlers(Animation* animation, AnimationHandlers callbacks, void* context);
+bool animation_schedule(Animation* animation);
+bool animation_unschedule(Animation* animation);
+bool animation_is_scheduled(Animation* animation);
+
+char const* i18n_get_system_locale(void);
+
+// persistent storage
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(uint32_t key);
+int persist_read_data(uint32_t key, void* buffer, size_t bufferSize);
+int persist_write_data(uint32_t key, void const* data, size_t size);
+int32_t persist_read_int(uint32_t key);
+int persist_write_int(uint32_t key, int32_t value);
+int persist_delete(uint32_t key);
+
+// app messages and dictionaries
+
+typedef enum
+{
+	TUPLE_BYTE_ARRAY = 0,
+	TUPLE_CSTRING = 1,
+	TUPLE_UINT = 2,
+	TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) Tuple
+{
+	uint32_t key;
+	TupleType type:8;
+	uint16_t length;
+	union
+	{
+		uint8_t data[0];
+		char cstring[0];
+		uint8_t uint8;
+		uint16_t uint16;
+		uint32_t uint32;
+		int8_t int8;
+		int16_t int16;
+		int32_t int32;
+	} value[];
+} Tuple;
+
+typedef struct DictionaryIterator
+{
+	uint8_t const* dictionary;
+	uint8_t const* end;
+	Tuple* cursor;
+} DictionaryIterator;
+
+Tuple* dict_read_first(DictionaryIterator* it);
+Tuple* dict_read_next(DictionaryIterator* it);
+Tuple* dict_find(DictionaryIterator const* it, uint32_t key);
+uint32_t dict_calc_buffer_size(uint8_t const tupleCount, ...);	// the size of each tuple's value follows
+
+typedef enum
+{
+	APP_MSG_OK = 0,
+	APP_MSG_SEND_TIMEOUT = 2,
+	APP_MSG_SEND_REJECTED = 4,
+	APP_MSG_NOT_CONNECTED = 8,
+	APP_MSG_BUFFER_OVERFLOW = 128,
+	APP_MSG_BUSY = 64,
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator* iterator, void* context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void* context);
+
+AppMessageResult app_message_open(uint32_t sizeInbound, uint32_t sizeOutbound);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped callback);
+
+// logging and the event loop
+
+typedef enum
+{
+	APP_LOG_LEVEL_ERROR = 1,
+	APP_LOG_LEVEL_WARNING = 50,
+	APP_LOG_LEVEL_INFO = 100,
+	APP_LOG_LEVEL_DEBUG = 200,
+	APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+void app_log(uint8_t level, char const* filename, int lineNumber, char const* fmt, ...) __attribute__((format(printf, 4, 5)));
+#define APP_LOG(level, fmt, args...)	app_log(level, __FILE__, __LINE__, fmt, ## args)
+
+void app_event_loop(void);
+
+#endif // PEBBLE_HOST_PEBBLE_H
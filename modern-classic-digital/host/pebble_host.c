@@ -0,0 +1,1492 @@
+// Software implementation of the stand-in Pebble SDK declared in pebble.h.
+//
+// Rendering follows the firmware's model: marking any layer dirty re-renders the whole window,
+// back-to-front, into a persistent framebuffer.  Every primitive samples pixel centers, so
+// adjacent fills (e.g. two radials split at the same angle) partition pixels exactly.
+
+#include "host.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+struct Layer
+{
+	GRect			frame,
+					bounds;
+	LayerUpdateProc	updateProc;
+	Layer*			parent;
+	Layer*			firstChild;
+	Layer*			nextSibling;
+};
+
+struct Window
+{
+	Layer			root;
+	WindowHandlers	handlers;
+	GColor			backgroundColor;
+	bool			loaded;
+};
+
+struct GContext
+{
+	GRect			drawBox;	// absolute frame of the layer being rendered, also the clip
+	GColor			fillColor,
+					strokeColor,
+					textColor;
+	uint8_t			strokeWidth;
+	bool			antialiased;	// on by default where the display has color, as on the watch
+};
+
+struct GBitmap
+{
+	uint8_t*		data;
+	GRect			bounds;
+	uint16_t		bytesPerRow;
+	GBitmapFormat	format;
+};
+
+struct GFont
+{
+	char const*		key;
+	int				glyphWidth,
+					glyphHeight,
+					advance,
+					lineHeight,
+					topPadding;
+};
+
+static uint8_t gFrameBuffer[HOST_SCREEN_HEIGHT][HOST_SCREEN_WIDTH];
+
+// antialiasing blends only where the display has color; the 1-bit ones draw hard edges
+#if defined(PBL_COLOR)
+static bool const kHostColor = true;
+#else
+static bool const kHostColor = false;
+#endif
+static HostDrawStats gDrawStats = {0};
+
+// direct framebuffer access is accounted for on release, by the pixels it changed
+#if defined(PBL_ROUND)
+static GBitmap gFrameBufferBitmap = {&gFrameBuffer[0][0], {{0, 0}, {HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT}}, HOST_SCREEN_WIDTH, GBitmapFormat8BitCircular};
+#else
+static GBitmap gFrameBufferBitmap = {&gFrameBuffer[0][0], {{0, 0}, {HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT}}, HOST_SCREEN_WIDTH, GBitmapFormat8Bit};
+#endif
+static uint8_t gCapturedFrameBuffer[HOST_SCREEN_HEIGHT][HOST_SCREEN_WIDTH];
+static bool gPixelWritten[HOST_SCREEN_HEIGHT][HOST_SCREEN_WIDTH];	// during the frame being rendered
+static bool gPixelBlended[HOST_SCREEN_HEIGHT][HOST_SCREEN_WIDTH];	// last written by an antialiased edge
+static bool gPixelBlendedInFrame[HOST_SCREEN_HEIGHT][HOST_SCREEN_WIDTH];	// by one, during the frame
+static bool gPixelOverwritten[HOST_SCREEN_HEIGHT][HOST_SCREEN_WIDTH];	// since then, only by direct access
+static bool gFrameBufferCaptured = false;
+static bool gRefuseAntialiasedCapture = false;
+static bool gCaptureAntialiased = false;	// the context it was captured through had antialiasing on
+
+static Window* gTopWindow = 0;
+static bool gRenderPending = false;
+
+static TickHandler gTickHandler = 0;
+static TimeUnits gTickUnits = 0;
+static struct tm gLastTick = {0};
+static bool gHaveLastTick = false;
+
+static AccelTapHandler gTapHandler = 0;
+static BatteryStateHandler gBatteryHandler = 0;
+static BatteryChargeState gBatteryState = {100, false, false};
+static ConnectionHandlers gConnectionHandlers = {0};
+static bool gConnected = true;
+static HealthValue gHealth[HealthMetricCount] = {-1, -1, -1, -1, -1, -1, -1, -1};
+static char const* gLocale = "en_US";
+
+static uint32_t gInboxSize = 0;
+static AppMessageInboxReceived gInboxReceived = 0;
+static AppMessageInboxDropped gInboxDropped = 0;
+
+static uint32_t gVibrationCount = 0;
+static uint32_t gTickCount = 0;
+
+static HostHeapStats gHeap = {0};
+
+////////////////////////////////////////////////////////////////
+// framebuffer
+
+// chalk's display is round: only pixels inside the inscribed circle exist
+static bool isOnScreen(int x, int y)
+{
+	if((x < 0) || (y < 0) || (x >= HOST_SCREEN_WIDTH) || (y >= HOST_SCREEN_HEIGHT))
+		return(false);
+#if defined(PBL_RECT)
+	return(true);
+#endif
+
+	float	dx = (x + 0.5f) - (HOST_SCREEN_WIDTH / 2.0f),
+			dy = (y + 0.5f) - (HOST_SCREEN_HEIGHT / 2.0f);
+	return((dx * dx + dy * dy) < ((HOST_SCREEN_WIDTH / 2.0f) * (HOST_SCREEN_WIDTH / 2.0f)));
+}
+
+// x and y are in the coordinates of the layer being rendered
+static void plot(GContext* context, int x, int y, GColor color)
+{
+	if(color.a == 0)
+		return;
+
+	if((x < 0) || (y < 0) || (x >= context->drawBox.size.w) || (y >= context->drawBox.size.h))
+		return;
+
+	x += context->drawBox.origin.x;
+	y += context->drawBox.origin.y;
+	if(!isOnScreen(x, y))
+		return;
+
+	gFrameBuffer[y][x] = color.argb;
+	gDrawStats.pixelsWritten++;
+	gPixelWritten[y][x] = true;
+	gPixelBlended[y][x] = false;
+	gPixelOverwritten[y][x] = false;
+}
+
+// blends color over the pixel by coverage quarters (0-4), per 2-bit channel, as antialiasing does
+static void blend(GContext* context, int x, int y, GColor color, int coverage)
+{
+	if(coverage >= 4)
+	{
+		plot(context, x, y, color);
+		return;
+	}
+	if((color.a == 0) || (coverage <= 0))
+		return;
+
+	if((x < 0) || (y < 0) || (x >= context->drawBox.size.w) || (y >= context->drawBox.size.h))
+		return;
+	x += context->drawBox.origin.x;
+	y += context->drawBox.origin.y;
+	if(!isOnScreen(x, y))
+		return;
+
+	uint8_t old = gFrameBuffer[y][x], mixed = 0xC0;
+	for(int shift = 0; shift < 6; shift += 2)
+		mixed |= ((((color.argb >> shift) & 3) * coverage + ((old >> shift) & 3) * (4 - coverage) + 2) / 4) << shift;
+	gFrameBuffer[y][x] = mixed;
+	gDrawStats.pixelsWritten++;
+	gPixelWritten[y][x] = true;
+	gPixelBlended[y][x] = true;
+	gPixelBlendedInFrame[y][x] = true;
+	gPixelOverwritten[y][x] = false;
+}
+
+uint8_t const* hostFrameBuffer(void)
+{
+	return(&gFrameBuffer[0][0]);
+}
+
+bool const* hostBlendedPixels(void)
+{
+	return(&gPixelBlended[0][0]);
+}
+
+void hostRefuseAntialiasedCapture(bool refuse)
+{
+	gRefuseAntialiasedCapture = refuse;
+}
+
+bool hostWriteFrameBuffer(char const* ppmPath)
+{
+	FILE* f = fopen(ppmPath, "wb");
+	if(f == 0)
+		return(false);
+
+	fprintf(f, "P6\n%d %d\n255\n", HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+	for(int y = 0; y < HOST_SCREEN_HEIGHT; y++)
+		for(int x = 0; x < HOST_SCREEN_WIDTH; x++)
+		{
+			GColor c = {.argb = gFrameBuffer[y][x]};
+			uint8_t rgb[3] = {(uint8_t)(c.r * 85), (uint8_t)(c.g * 85), (uint8_t)(c.b * 85)};
+			if(!isOnScreen(x, y))
+				rgb[0] = rgb[1] = rgb[2] = 0;
+			fwrite(rgb, 1, 3, f);
+		}
+
+	return(fclose(f) == 0);
+}
+
+uint32_t hostCompareFrameBuffer(char const* ppmPath, GRect* differing)
+{
+	FILE* f = fopen(ppmPath, "rb");
+	if(f == 0)
+		return(UINT32_MAX);
+
+	int width = 0, height = 0, depth = 0;
+	bool readable = (fscanf(f, "P6 %d %d %d", &width, &height, &depth) == 3) && (fgetc(f) != EOF)
+					&& (width == HOST_SCREEN_WIDTH) && (height == HOST_SCREEN_HEIGHT) && (depth == 255);
+
+	uint32_t count = 0;
+	int minX = HOST_SCREEN_WIDTH, minY = HOST_SCREEN_HEIGHT, maxX = -1, maxY = -1;
+	for(int y = 0; readable && (y < HOST_SCREEN_HEIGHT); y++)
+		for(int x = 0; readable && (x < HOST_SCREEN_WIDTH); x++)
+		{
+			// as hostWriteFrameBuffer wrote it
+			GColor c = {.argb = gFrameBuffer[y][x]};
+			uint8_t rgb[3] = {(uint8_t)(c.r * 85), (uint8_t)(c.g * 85), (uint8_t)(c.b * 85)}, saved[3];
+			if(!isOnScreen(x, y))
+				rgb[0] = rgb[1] = rgb[2] = 0;
+
+			readable = (fread(saved, 1, 3, f) == 3);
+			if(readable && (memcmp(rgb, saved, 3) != 0))
+			{
+				count++;
+				minX = (x < minX)? x : minX;
+				maxX = (x > maxX)? x : maxX;
+				minY = (y < minY)? y : minY;
+				maxY = (y > maxY)? y : maxY;
+			}
+		}
+	fclose(f);
+
+	if(!readable)
+		return(UINT32_MAX);
+	if(differing != 0)
+		*differing = (count > 0)? GRect(minX, minY, maxX - minX + 1, maxY - minY + 1) : GRectZero;
+	return(count);
+}
+
+////////////////////////////////////////////////////////////////
+// trigonometry
+
+int32_t sin_lookup(int32_t angle)
+{
+	gDrawStats.trigLookups++;
+	return((int32_t)lround(sin(angle * (2.0 * M_PI / TRIG_MAX_ANGLE)) * TRIG_MAX_RATIO));
+}
+
+int32_t cos_lookup(int32_t angle)
+{
+	gDrawStats.trigLookups++;
+	return((int32_t)lround(cos(angle * (2.0 * M_PI / TRIG_MAX_ANGLE)) * TRIG_MAX_RATIO));
+}
+
+int32_t atan2_lookup(int16_t y, int16_t x)
+{
+	gDrawStats.trigLookups++;
+	double a = atan2(y, x);
+	if(a < 0)
+		a += 2.0 * M_PI;
+	int32_t t = (int32_t)lround(a * (TRIG_MAX_ANGLE / (2.0 * M_PI)));
+	return((t >= TRIG_MAX_ANGLE)? 0 : t);
+}
+
+// angle of (dx, dy) clockwise from 12 o'clock, in [0, TRIG_MAX_ANGLE)
+static int32_t trigAngleOf(float dx, float dy)
+{
+	double a = atan2(dx, -dy);
+	if(a < 0)
+		a += 2.0 * M_PI;
+	int32_t t = (int32_t)(a * (TRIG_MAX_ANGLE / (2.0 * M_PI)));
+	return((t >= TRIG_MAX_ANGLE)? 0 : t);
+}
+
+GPoint gpoint_from_polar(GRect rect, GOvalScaleMode scaleMode, int32_t angle)
+{
+	gDrawStats.trigLookups++;
+	float	rx = (rect.size.w - 1) / 2.0f,
+			ry = (rect.size.h - 1) / 2.0f;
+	if(scaleMode == GOvalScaleModeFitCircle)
+		rx = ry = (rx < ry)? rx : ry;
+	else
+		rx = ry = (rx > ry)? rx : ry;
+
+	double a = angle * (2.0 * M_PI / TRIG_MAX_ANGLE);
+	return(GPoint(	(int16_t)lround(rect.origin.x + (rect.size.w - 1) / 2.0f + sin(a) * rx),
+					(int16_t)lround(rect.origin.y + (rect.size.h - 1) / 2.0f - cos(a) * ry)
+				));
+}
+
+////////////////////////////////////////////////////////////////
+// drawing primitives
+
+void graphics_context_set_fill_color(GContext* context, GColor color)	{ context->fillColor = color; }
+void graphics_context_set_stroke_color(GContext* context, GColor color)	{ context->strokeColor = color; }
+void graphics_context_set_stroke_width(GContext* context, uint8_t width)	{ context->strokeWidth = (width == 0)? 1 : width; }
+void graphics_context_set_text_color(GContext* context, GColor color)	{ context->textColor = color; }
+void graphics_context_set_antialiased(GContext* context, bool enable)	{ context->antialiased = enable && kHostColor; }
+
+void graphics_fill_rect(GContext* context, GRect rect, uint16_t cornerRadius, GCornerMask cornerMask)
+{
+	(void)cornerRadius; (void)cornerMask;
+	gDrawStats.drawCalls++;
+
+	for(int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++)
+		for(int x = rect.origin.x; x < rect.origin.x + rect.size.w; x++)
+			plot(context, x, y, context->fillColor);
+}
+
+// fills the band outerRadius > r >= innerRadius between two clockwise angles, sampled at pixel
+// centers; antialiased, the pixels within half a pixel of its edges are blended by how far inside
+// they are instead
+static void fillAnnulus(GContext* context, float cx, float cy, float outerRadius, float innerRadius, int32_t angleStart, int32_t angleEnd)
+{
+	int32_t span = angleEnd - angleStart;
+	if(span <= 0)
+		return;
+	bool full = (span >= TRIG_MAX_ANGLE);
+	angleStart = ((angleStart % TRIG_MAX_ANGLE) + TRIG_MAX_ANGLE) % TRIG_MAX_ANGLE;
+
+	float	outer2 = outerRadius * outerRadius,
+			inner2 = (innerRadius > 0)? (innerRadius * innerRadius) : -1.0f;
+
+	int	x0 = (int)floorf(cx - outerRadius), x1 = (int)ceilf(cx + outerRadius),
+		y0 = (int)floorf(cy - outerRadius), y1 = (int)ceilf(cy + outerRadius);
+
+	// a partial wedge only scans its own bounding box: the end points at both radii, the
+	// cardinal extremes it spans and, for a pie, the center
+	if(!full)
+	{
+		float	minX = cx, maxX = cx, minY = cy, maxY = cy;
+		bool	first = (innerRadius > 0);
+		float	ends[2] = {angleStart * (2.0f * (float)M_PI / TRIG_MAX_ANGLE), (angleStart + span) * (2.0f * (float)M_PI / TRIG_MAX_ANGLE)};
+		for(int i = 0; i < 4; i++)
+		{
+			float	a = ends[i & 1],
+					r = (i < 2)? outerRadius : ((innerRadius > 0)? innerRadius : 0),
+					px = cx + sinf(a) * r,
+					py = cy - cosf(a) * r;
+			if(first)	{ minX = maxX = px; minY = maxY = py; first = false; }
+			if(px < minX)	minX = px;
+			if(px > maxX)	maxX = px;
+			if(py < minY)	minY = py;
+			if(py > maxY)	maxY = py;
+		}
+		for(int quarter = 0; quarter < 4; quarter++)
+		{
+			int32_t cardinal = quarter * (TRIG_MAX_ANGLE / 4);
+			if((((cardinal - angleStart) + TRIG_MAX_ANGLE) % TRIG_MAX_ANGLE) >= span)
+				continue;
+			switch(quarter)
+			{
+			case 0:	minY = cy - outerRadius;	break;
+			case 1:	maxX = cx + outerRadius;	break;
+			case 2:	maxY = cy + outerRadius;	break;
+			case 3:	minX = cx - outerRadius;	break;
+			}
+		}
+		x0 = (int)floorf(minX) - 1;	x1 = (int)ceilf(maxX) + 1;
+		y0 = (int)floorf(minY) - 1;	y1 = (int)ceilf(maxY) + 1;
+	}
+
+	if(context->antialiased)
+	{
+		// how far inside each edge a pixel center is: the radii, and the lines through the center
+		// along the start and end angles (both, for a wedge of up to half a turn, else either)
+		float	start = angleStart * (2.0f * (float)M_PI / TRIG_MAX_ANGLE),
+				end = (angleStart + span) * (2.0f * (float)M_PI / TRIG_MAX_ANGLE),
+				startSin = sinf(start), startCos = cosf(start), endSin = sinf(end), endCos = cosf(end);
+		for(int y = y0 - 1; y <= y1 + 1; y++)
+			for(int x = x0 - 1; x <= x1 + 1; x++)
+			{
+				float	dx = (x + 0.5f) - cx,
+						dy = (y + 0.5f) - cy,
+						d = sqrtf(dx * dx + dy * dy),
+						inside = outerRadius - d;
+				if((innerRadius > 0) && ((d - innerRadius) < inside))
+					inside = d - innerRadius;
+				if(!full)
+				{
+					float	afterStart = dx * startCos + dy * startSin,
+							beforeEnd = -(dx * endCos + dy * endSin),
+							within = (span <= TRIG_MAX_ANGLE / 2)? fminf(afterStart, beforeEnd) : fmaxf(afterStart, beforeEnd);
+					if(within < inside)
+						inside = within;
+				}
+				blend(context, x, y, context->fillColor, (int)floorf((inside + 0.5f) * 4.0f + 0.5f));
+			}
+		return;
+	}
+
+	for(int y = y0; y <= y1; y++)
+		for(int x = x0; x <= x1; x++)
+		{
+			float	dx = (x + 0.5f) - cx,
+					dy = (y + 0.5f) - cy,
+					d2 = dx * dx + dy * dy;
+			if((d2 >= outer2) || (d2 < inner2))
+				continue;
+			if(!full && ((((trigAngleOf(dx, dy) - angleStart) + TRIG_MAX_ANGLE) % TRIG_MAX_ANGLE) >= span))
+				continue;
+			plot(context, x, y, context->fillColor);
+		}
+}
+
+void graphics_fill_circle(GContext* context, GPoint center, uint16_t radius)
+{
+	gDrawStats.drawCalls++;
+	fillAnnulus(context, center.x, center.y, radius, 0, 0, TRIG_MAX_ANGLE);
+}
+
+void graphics_fill_radial(GContext* context, GRect rect, GOvalScaleMode scaleMode, uint16_t insetThickness, int32_t angleStart, int32_t angleEnd)
+{
+	gDrawStats.drawCalls++;
+
+	float	rx = rect.size.w / 2.0f,
+			ry = rect.size.h / 2.0f,
+			r = (scaleMode == GOvalScaleModeFitCircle)? ((rx < ry)? rx : ry) : ((rx > ry)? rx : ry);
+
+	fillAnnulus(	context, rect.origin.x + rx, rect.origin.y + ry,
+					r, r - insetThickness, angleStart, angleEnd
+				);
+}
+
+void graphics_draw_line(GContext* context, GPoint p0, GPoint p1)
+{
+	gDrawStats.drawCalls++;
+
+	if(context->strokeWidth <= 1)
+	{
+		int	dx = abs(p1.x - p0.x), sx = (p0.x < p1.x)? 1 : -1,
+			dy = -abs(p1.y - p0.y), sy = (p0.y < p1.y)? 1 : -1,
+			err = dx + dy,
+			x = p0.x, y = p0.y;
+		for(;;)
+		{
+			plot(context, x, y, context->strokeColor);
+			if((x == p1.x) && (y == p1.y))
+				break;
+			int e2 = 2 * err;
+			if(e2 >= dy) { err += dy; x += sx; }
+			if(e2 <= dx) { err += dx; y += sy; }
+		}
+		return;
+	}
+
+	// wide strokes are capsules: every pixel within half the width of the segment
+	float	half = context->strokeWidth / 2.0f,
+			ax = p0.x + 0.5f, ay = p0.y + 0.5f,
+			vx = p1.x - p0.x, vy = p1.y - p0.y,
+			len2 = vx * vx + vy * vy;
+	int	minX = (int)floorf(fminf(p0.x, p1.x) - half), maxX = (int)ceilf(fmaxf(p0.x, p1.x) + half),
+		minY = (int)floorf(fminf(p0.y, p1.y) - half), maxY = (int)ceilf(fmaxf(p0.y, p1.y) + half);
+
+	for(int y = minY; y <= maxY; y++)
+		for(int x = minX; x <= maxX; x++)
+		{
+			float	px = (x + 0.5f) - ax, py = (y + 0.5f) - ay,
+					t = (len2 > 0)? ((px * vx + py * vy) / len2) : 0;
+			t = (t < 0)? 0 : ((t > 1)? 1 : t);
+			float ex = px - t * vx, ey = py - t * vy;
+			if((ex * ex + ey * ey) <= (half * half))
+				plot(context, x, y, context->strokeColor);
+		}
+}
+
+////////////////////////////////////////////////////////////////
+// heap
+
+// What the watchface allocates through the SDK: windows, layers, animations and bitmaps at the
+// host's sizes for them, and the AppMessage buffers at the sizes asked for.  The host's structures
+// hold 64-bit pointers, so that's a little more than the watch would need.
+static void heapAllocated(uint32_t* categoryBytes, uint32_t* categoryPeak, int32_t bytes)
+{
+	*categoryBytes += bytes;
+	gHeap.bytes += bytes;
+	if(*categoryBytes > *categoryPeak)
+		*categoryPeak = *categoryBytes;
+	if(gHeap.bytes > gHeap.peakBytes)
+		gHeap.peakBytes = gHeap.bytes;
+}
+
+HostHeapStats hostHeapStats(void)	{ return(gHeap); }
+
+////////////////////////////////////////////////////////////////
+// bitmaps and direct framebuffer access
+//
+// Only 8-bit bitmaps are supported.  The framebuffer is circular: each row's data covers only
+// the pixels that exist on the round display.
+
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format)
+{
+	if((format != GBitmapFormat8Bit) || (size.w <= 0) || (size.h <= 0))
+		return(0);
+
+	GBitmap* bitmap = calloc(1, sizeof(GBitmap));
+	bitmap->data = calloc((size_t)size.w * size.h, 1);
+	bitmap->bounds = GRect(0, 0, size.w, size.h);
+	bitmap->bytesPerRow = size.w;
+	bitmap->format = format;
+	heapAllocated(&gHeap.bitmapBytes, &gHeap.peakBitmapBytes, sizeof(GBitmap) + ((int32_t)size.w * size.h));
+	return(bitmap);
+}
+
+void gbitmap_destroy(GBitmap* bitmap)
+{
+	if((bitmap == 0) || (bitmap == &gFrameBufferBitmap))
+		return;
+	heapAllocated(&gHeap.bitmapBytes, &gHeap.peakBitmapBytes, -(int32_t)(sizeof(GBitmap) + (bitmap->bounds.size.w * bitmap->bounds.size.h)));
+	free(bitmap->data);
+	free(bitmap);
+}
+
+uint8_t* gbitmap_get_data(GBitmap const* bitmap)				{ return(bitmap->data); }
+uint16_t gbitmap_get_bytes_per_row(GBitmap const* bitmap)		{ return(bitmap->bytesPerRow); }
+GRect gbitmap_get_bounds(GBitmap const* bitmap)					{ return(bitmap->bounds); }
+GBitmapFormat gbitmap_get_format(GBitmap const* bitmap)			{ return(bitmap->format); }
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(GBitmap const* bitmap, uint16_t y)
+{
+	GBitmapDataRowInfo info = {bitmap->data + (size_t)y * bitmap->bytesPerRow, 0, (int16_t)(bitmap->bounds.size.w - 1)};
+	if(bitmap == &gFrameBufferBitmap)
+	{
+		while((info.min_x <= info.max_x) && !isOnScreen(info.min_x, y))
+			info.min_x++;
+		while((info.max_x >= info.min_x) && !isOnScreen(info.max_x, y))
+			info.max_x--;
+	}
+	return(info);
+}
+
+void graphics_context_set_compositing_mode(GContext* context, GCompOp mode)	{ (void)context; (void)mode; }
+
+void graphics_draw_bitmap_in_rect(GContext* context, GBitmap const* bitmap, GRect rect)
+{
+	gDrawStats.drawCalls++;
+
+	for(int y = 0; (y < rect.size.h) && (y < bitmap->bounds.size.h); y++)
+	{
+		uint8_t const* row = bitmap->data + (size_t)y * bitmap->bytesPerRow;
+		for(int x = 0; (x < rect.size.w) && (x < bitmap->bounds.size.w); x++)
+			plot(context, rect.origin.x + x, rect.origin.y + y, (GColor){.argb = row[x]});
+	}
+}
+
+GBitmap* graphics_capture_frame_buffer(GContext* context)
+{
+	if(gFrameBufferCaptured || (gRefuseAntialiasedCapture && context->antialiased))
+		return(0);
+
+	gFrameBufferCaptured = true;
+	gCaptureAntialiased = context->antialiased;
+	memcpy(gCapturedFrameBuffer, gFrameBuffer, sizeof(gFrameBuffer));
+	return(&gFrameBufferBitmap);
+}
+
+bool graphics_release_frame_buffer(GContext* context, GBitmap* buffer)
+{
+	(void)context;
+	if(!gFrameBufferCaptured || (buffer != &gFrameBufferBitmap))
+		return(false);
+
+	gFrameBufferCaptured = false;
+	gDrawStats.drawCalls++;
+	for(int y = 0; y < HOST_SCREEN_HEIGHT; y++)
+	{
+		// most rows are untouched; skip them cheaply so the accounting doesn't dwarf the drawing
+		if(memcmp(gFrameBuffer[y], gCapturedFrameBuffer[y], sizeof(gFrameBuffer[y])) == 0)
+			continue;
+		for(int x = 0; x < HOST_SCREEN_WIDTH; x++)
+		{
+			if(gFrameBuffer[y][x] == gCapturedFrameBuffer[y][x])
+				continue;
+			gDrawStats.pixelsWritten++;
+			gPixelWritten[y][x] = true;
+			gPixelBlended[y][x] = false;
+			gPixelOverwritten[y][x] |= (gCaptureAntialiased && gPixelBlendedInFrame[y][x]);
+		}
+	}
+	return(true);
+}
+
+////////////////////////////////////////////////////////////////
+// text
+//
+// System fonts are approximated by scaling a 5x7 bitmap font to each font's metrics.  Glyphs
+// outside the table (e.g. Cyrillic or Arabic) render as a hollow box of the same size.
+
+static struct GFont const kFonts[] =
+{
+	{FONT_KEY_GOTHIC_09,				5,	7,	6,	9,	2},
+	{FONT_KEY_GOTHIC_14,				5,	9,	7,	14,	4},
+	{FONT_KEY_GOTHIC_18,				7,	11,	9,	18,	5},
+	{FONT_KEY_GOTHIC_24,				9,	15,	11,	24,	6},
+	{FONT_KEY_LECO_20_BOLD_NUMBERS,		10,	14,	12,	20,	3},
+	{FONT_KEY_LECO_28_LIGHT_NUMBERS,	14,	20,	17,	28,	4},
+};
+
+static uint8_t const kGlyphDigits[10][7] =
+{
+	{0x0E,0x11,0x13,0x15,0x19,0x11,0x0E}, {0x04,0x0C,0x04,0x04,0x04,0x04,0x0E},
+	{0x0E,0x11,0x01,0x02,0x04,0x08,0x1F}, {0x1F,0x02,0x04,0x02,0x01,0x11,0x0E},
+	{0x02,0x06,0x0A,0x12,0x1F,0x02,0x02}, {0x1F,0x10,0x1E,0x01,0x01,0x11,0x0E},
+	{0x06,0x08,0x10,0x1E,0x11,0x11,0x0E}, {0x1F,0x01,0x02,0x04,0x08,0x08,0x08},
+	{0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E}, {0x0E,0x11,0x11,0x0F,0x01,0x02,0x0C},
+};
+
+static uint8_t const kGlyphLetters[26][7] =
+{
+	{0x0E,0x11,0x11,0x1F,0x11,0x11,0x11}, {0x1E,0x11,0x11,0x1E,0x11,0x11,0x1E},
+	{0x0E,0x11,0x10,0x10,0x10,0x11,0x0E}, {0x1C,0x12,0x11,0x11,0x11,0x12,0x1C},
+	{0x1F,0x10,0x10,0x1E,0x10,0x10,0x1F}, {0x1F,0x10,0x10,0x1E,0x10,0x10,0x10},
+	{0x0E,0x11,0x10,0x17,0x11,0x11,0x0F}, {0x11,0x11,0x11,0x1F,0x11,0x11,0x11},
+	{0x0E,0x04,0x04,0x04,0x04,0x04,0x0E}, {0x07,0x02,0x02,0x02,0x02,0x12,0x0C},
+	{0x11,0x12,0x14,0x18,0x14,0x12,0x11}, {0x10,0x10,0x10,0x10,0x10,0x10,0x1F},
+	{0x11,0x1B,0x15,0x15,0x11,0x11,0x11}, {0x11,0x11,0x19,0x15,0x13,0x11,0x11},
+	{0x0E,0x11,0x11,0x11,0x11,0x11,0x0E}, {0x1E,0x11,0x11,0x1E,0x10,0x10,0x10},
+	{0x0E,0x11,0x11,0x11,0x15,0x12,0x0D}, {0x1E,0x11,0x11,0x1E,0x14,0x12,0x11},
+	{0x0F,0x10,0x10,0x0E,0x01,0x01,0x1E}, {0x1F,0x04,0x04,0x04,0x04,0x04,0x04},
+	{0x11,0x11,0x11,0x11,0x11,0x11,0x0E}, {0x11,0x11,0x11,0x11,0x11,0x0A,0x04},
+	{0x11,0x11,0x11,0x15,0x15,0x15,0x0A}, {0x11,0x11,0x0A,0x04,0x0A,0x11,0x11},
+	{0x11,0x11,0x11,0x0A,0x04,0x04,0x04}, {0x1F,0x01,0x02,0x04,0x08,0x10,0x1F},
+};
+
+static uint8_t const kGlyphPeriod[7] =	{0x00,0x00,0x00,0x00,0x00,0x0C,0x0C};
+static uint8_t const kGlyphPercent[7] =	{0x18,0x19,0x02,0x04,0x08,0x13,0x03};
+static uint8_t const kGlyphPlus[7] =	{0x00,0x04,0x04,0x1F,0x04,0x04,0x00};
+static uint8_t const kGlyphColon[7] =	{0x00,0x0C,0x0C,0x00,0x0C,0x0C,0x00};
+static uint8_t const kGlyphMinus[7] =	{0x00,0x00,0x00,0x1F,0x00,0x00,0x00};
+static uint8_t const kGlyphUnknown[7] =	{0x1F,0x11,0x11,0x11,0x11,0x11,0x1F};
+static uint8_t const kGlyphSpace[7] =	{0};
+
+GFont fonts_get_system_font(char const* fontKey)
+{
+	for(size_t i = 0; i < sizeof(kFonts) / sizeof(kFonts[0]); i++)
+		if(strcmp(kFonts[i].key, fontKey) == 0)
+			return((GFont)&kFonts[i]);
+	return((GFont)&kFonts[0]);
+}
+
+static uint32_t nextCodepoint(char const** text)
+{
+	uint8_t const* s = (uint8_t const*)*text;
+	uint32_t cp = *s++;
+	int extra = (cp >= 0xF0)? 3 : (cp >= 0xE0)? 2 : (cp >= 0xC0)? 1 : 0;
+	if(extra)
+		cp &= (0x3F >> extra);
+	while(extra-- && ((*s & 0xC0) == 0x80))
+		cp = (cp << 6) | (*s++ & 0x3F);
+	*text = (char const*)s;
+	return(cp);
+}
+
+static uint8_t const* glyphFor(uint32_t cp)
+{
+	if((cp >= '0') && (cp <= '9'))	return(kGlyphDigits[cp - '0']);
+	if((cp >= 'A') && (cp <= 'Z'))	return(kGlyphLetters[cp - 'A']);
+	if((cp >= 'a') && (cp <= 'z'))	return(kGlyphLetters[cp - 'a']);
+	switch(cp)
+	{
+	case ' ':	return(kGlyphSpace);
+	case '.':	return(kGlyphPeriod);
+	case '%':	return(kGlyphPercent);
+	case '+':	return(kGlyphPlus);
+	case ':':	return(kGlyphColon);
+	case '-':	return(kGlyphMinus);
+	}
+	return(kGlyphUnknown);
+}
+
+static int codepointCount(char const* text, size_t length)
+{
+	int n = 0;
+	for(char const* end = text + length; text < end; n++)
+		nextCodepoint(&text);
+	return(n);
+}
+
+// breaks text into lines at newlines, and at spaces when a line would overflow the box width;
+// invokes emit (if any) for each line and returns the content size
+typedef void (*LineEmitter)(GContext* context, struct GFont const* font, char const* line, size_t length, int x, int y);
+
+static GSize layoutText(GContext* context, char const* text, struct GFont const* font, GRect box, GTextAlignment alignment, LineEmitter emit)
+{
+	int y = font->topPadding, maxWidth = 0;
+	char const* cursor = text;
+
+	while(*cursor != 0)
+	{
+		size_t length = strcspn(cursor, "\n");
+
+		// word wrap: shorten the line to the last space that fits
+		while((codepointCount(cursor, length) * font->advance > box.size.w) && (length > 0))
+		{
+			char const* space = 0;
+			for(char const* p = cursor; p < cursor + length; p++)
+				if(*p == ' ')
+					space = p;
+			if((space == 0) || (space == cursor))
+				break;
+			length = space - cursor;
+		}
+
+		int width = codepointCount(cursor, length) * font->advance;
+		if(width > maxWidth)
+			maxWidth = width;
+
+		int x = 0;
+		if(alignment == GTextAlignmentCenter)		x = (box.size.w - width) / 2;
+		else if(alignment == GTextAlignmentRight)	x = box.size.w - width;
+
+		if(emit != 0)
+			emit(context, font, cursor, length, box.origin.x + x, box.origin.y + y);
+
+		y += font->lineHeight;
+		cursor += length;
+		while((*cursor == '\n') || (*cursor == ' '))
+			cursor++;
+	}
+
+	return(GSize(maxWidth, (y > font->topPadding)? (y - font->topPadding) : 0));
+}
+
+static void drawLine(GContext* context, struct GFont const* font, char const* line, size_t length, int x, int y)
+{
+	for(char const* end = line + length; line < end; x += font->advance)
+	{
+		uint8_t const* glyph = glyphFor(nextCodepoint(&line));
+		for(int gy = 0; gy < font->glyphHeight; gy++)
+		{
+			uint8_t row = glyph[(gy * 7) / font->glyphHeight];
+			for(int gx = 0; gx < font->glyphWidth; gx++)
+				if(row & (0x10 >> ((gx * 5) / font->glyphWidth)))
+					plot(context, x + gx, y + gy, context->textColor);
+		}
+	}
+}
+
+void graphics_draw_text(GContext* context, char const* text, GFont const font, GRect const box, GTextOverflowMode const overflowMode, GTextAlignment const alignment, GTextAttributes* const textAttributes)
+{
+	(void)overflowMode; (void)textAttributes;
+	gDrawStats.drawCalls++;
+	gDrawStats.textLayouts++;
+	layoutText(context, text, font, box, alignment, &drawLine);
+}
+
+GSize graphics_text_layout_get_content_size(char const* text, GFont const font, GRect const box, GTextOverflowMode const overflowMode, GTextAlignment const alignment)
+{
+	(void)overflowMode;
+	gDrawStats.textLayouts++;
+	return(layoutText(0, text, font, box, alignment, 0));
+}
+
+////////////////////////////////////////////////////////////////
+// windows and layers
+
+Window* window_create(void)
+{
+	Window* window = calloc(1, sizeof(Window));
+	heapAllocated(&gHeap.layerBytes, &gHeap.peakLayerBytes, sizeof(Window));
+	window->root.frame = window->root.bounds = GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+	window->backgroundColor = GColorWhite;
+	return(window);
+}
+
+void window_destroy(Window* window)
+{
+	if(gTopWindow == window)
+		gTopWindow = 0;
+	heapAllocated(&gHeap.layerBytes, &gHeap.peakLayerBytes, -(int32_t)sizeof(Window));
+	free(window);
+}
+
+void window_set_window_handlers(Window* window, WindowHandlers handlers)	{ window->handlers = handlers; }
+void window_set_background_color(Window* window, GColor color)				{ window->backgroundColor = color; }
+Layer* window_get_root_layer(Window const* window)							{ return((Layer*)&window->root); }
+
+void hostRedisplayWindow(void)
+{
+	if(gTopWindow == 0)
+		return;
+	if(gTopWindow->handlers.disappear != 0)
+		gTopWindow->handlers.disappear(gTopWindow);
+	if(gTopWindow->handlers.appear != 0)
+		gTopWindow->handlers.appear(gTopWindow);
+	gRenderPending = true;
+}
+
+void window_stack_push(Window* window, bool animated)
+{
+	(void)animated;
+	gTopWindow = window;
+	if(!window->loaded)
+	{
+		window->loaded = true;
+		if(window->handlers.load != 0)
+			window->handlers.load(window);
+	}
+	if(window->handlers.appear != 0)
+		window->handlers.appear(window);
+	gRenderPending = true;
+}
+
+Layer* layer_create(GRect frame)
+{
+	Layer* layer = calloc(1, sizeof(Layer));
+	heapAllocated(&gHeap.layerBytes, &gHeap.peakLayerBytes, sizeof(Layer));
+	layer->frame = frame;
+	layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+	return(layer);
+}
+
+void layer_destroy(Layer* layer)
+{
+	heapAllocated(&gHeap.layerBytes, &gHeap.peakLayerBytes, -(int32_t)sizeof(Layer));
+	free(layer);
+}
+
+void layer_add_child(Layer* parent, Layer* child)
+{
+	child->parent = parent;
+	Layer** link = &parent->firstChild;
+	while(*link != 0)
+		link = &(*link)->nextSibling;
+	*link = child;
+}
+
+void layer_set_update_proc(Layer* layer, LayerUpdateProc updateProc)	{ layer->updateProc = updateProc; }
+GRect layer_get_bounds(Layer const* layer)								{ return(layer->bounds); }
+GRect layer_get_frame(Layer const* layer)								{ return(layer->frame); }
+
+// as on the watch, dirtying any layer re-renders the whole window
+void layer_mark_dirty(Layer* layer)
+{
+	(void)layer;
+	gRenderPending = true;
+}
+
+uint16_t time_ms(time_t* seconds, uint16_t* milliseconds)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	uint16_t ms = (uint16_t)(ts.tv_nsec / 1000000);
+	if(seconds != 0)
+		*seconds = ts.tv_sec;
+	if(milliseconds != 0)
+		*milliseconds = ms;
+	return(ms);
+}
+
+time_t hostTime(time_t* seconds)
+{
+	time_t now;
+	if(gHaveLastTick)
+	{
+		struct tm simulated = gLastTick;
+		now = mktime(&simulated);
+	}
+	else
+		time_ms(&now, 0);
+	if(seconds != 0)
+		*seconds = now;
+	return(now);
+}
+
+uint64_t hostNanoseconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+static void addDrawStats(HostDrawStats* total, HostDrawStats const* delta)
+{
+	total->pixelsWritten += delta->pixelsWritten;
+	total->drawCalls += delta->drawCalls;
+	total->textLayouts += delta->textLayouts;
+	total->trigLookups += delta->trigLookups;
+}
+
+// The stack an update proc uses is measured by painting the stack below the caller's frame, then
+// finding how far down the paint was disturbed: the same frame does both, so its area starts
+// where the update proc's frame does both times.
+enum { kStackPaintBytes = 64 * 1024, kStackPaint = 0xA5 };
+
+static __attribute__((noinline)) uint32_t stackPaint(bool paint)
+{
+	uint8_t area[kStackPaintBytes];
+	uint8_t volatile* volatile bottom = area;	// what's found there is the point, initialized or not
+	size_t lowest = 0;
+	if(paint)
+	{
+		for(size_t i = 0; i < sizeof(area); i++)
+			bottom[i] = kStackPaint;
+	}
+	else
+	{
+		while((lowest < sizeof(area)) && (bottom[lowest] == kStackPaint))
+			lowest++;
+	}
+	return((uint32_t)(sizeof(area) - lowest));
+}
+
+static void renderLayerTree(Layer* layer, GPoint origin, HostFrameStats* stats)
+{
+	for(Layer* child = layer->firstChild; child != 0; child = child->nextSibling)
+	{
+		GPoint childOrigin = GPoint(origin.x + child->frame.origin.x, origin.y + child->frame.origin.y);
+
+		if(child->updateProc != 0)
+		{
+			GContext context =
+			{
+				.drawBox = {childOrigin, child->frame.size},
+				.fillColor = GColorBlack,
+				.strokeColor = GColorBlack,
+				.textColor = GColorBlack,
+				.strokeWidth = 1,
+				.antialiased = kHostColor,
+			};
+
+			gDrawStats = (HostDrawStats){0};
+			stackPaint(true);
+			uint64_t start = hostNanoseconds();
+			child->updateProc(child, &context);
+			uint64_t elapsed = hostNanoseconds() - start;
+			uint32_t stackBytes = stackPaint(false);
+
+			if(stats->layerCount < HOST_MAX_LAYERS)
+			{
+				HostLayerStats* s = &stats->layers[stats->layerCount++];
+				s->layer = child;
+				s->renderNanoseconds = elapsed;
+				s->stackBytes = stackBytes;
+				s->draw = gDrawStats;
+			}
+			stats->renderNanoseconds += elapsed;
+			addDrawStats(&stats->draw, &gDrawStats);
+		}
+
+		renderLayerTree(child, childOrigin, stats);
+	}
+}
+
+bool hostRenderFrame(HostFrameStats* stats)
+{
+	HostFrameStats ignored;
+	if(stats == 0)
+		stats = &ignored;
+	*stats = (HostFrameStats){0};
+
+	if(!gRenderPending || (gTopWindow == 0))
+		return(false);
+	gRenderPending = false;
+
+	GContext context = {.drawBox = gTopWindow->root.frame, .antialiased = kHostColor};
+	gDrawStats = (HostDrawStats){0};
+	memset(gPixelWritten, 0, sizeof(gPixelWritten));
+	memset(gPixelBlendedInFrame, 0, sizeof(gPixelBlendedInFrame));
+	memset(gPixelOverwritten, 0, sizeof(gPixelOverwritten));
+	uint64_t start = hostNanoseconds();
+	if(gTopWindow->backgroundColor.a != 0)
+	{
+		graphics_context_set_fill_color(&context, gTopWindow->backgroundColor);
+		graphics_fill_rect(&context, gTopWindow->root.bounds, 0, GCornerNone);
+	}
+	stats->renderNanoseconds = hostNanoseconds() - start;
+	stats->draw = gDrawStats;
+
+	renderLayerTree(&gTopWindow->root, gTopWindow->root.frame.origin, stats);
+
+	for(int y = 0; y < HOST_SCREEN_HEIGHT; y++)
+		for(int x = 0; x < HOST_SCREEN_WIDTH; x++)
+		{
+			stats->pixelsCovered += gPixelWritten[y][x];
+			stats->antialiasingOverwritten += gPixelOverwritten[y][x];
+		}
+	return(true);
+}
+
+////////////////////////////////////////////////////////////////
+// event services
+
+void tick_timer_service_subscribe(TimeUnits tickUnits, TickHandler handler)
+{
+	gTickUnits = tickUnits;
+	gTickHandler = handler;
+}
+
+void tick_timer_service_unsubscribe(void)
+{
+	gTickUnits = 0;
+	gTickHandler = 0;
+}
+
+#define kAnimations 4
+
+struct Animation
+{
+	bool							used,
+									scheduled;
+	uint32_t						durationMs,
+									elapsedMs;
+	AnimationImplementation const*	implementation;
+	AnimationHandlers				handlers;
+	void*							context;
+};
+
+static Animation gAnimations[kAnimations];
+
+Animation* animation_create(void)
+{
+	for(int i = 0; i < kAnimations; i++)
+	{
+		if(gAnimations[i].used)
+			continue;
+		gAnimations[i] = (Animation){.used = true, .durationMs = 250};
+		heapAllocated(&gHeap.layerBytes, &gHeap.peakLayerBytes, sizeof(Animation));
+		return(&gAnimations[i]);
+	}
+	return(0);
+}
+
+bool animation_destroy(Animation* animation)
+{
+	if((animation == 0) || !animation->used)
+		return(false);
+	animation->used = false;
+	heapAllocated(&gHeap.layerBytes, &gHeap.peakLayerBytes, -(int32_t)sizeof(Animation));
+	return(true);
+}
+
+bool animation_set_duration(Animation* animation, uint32_t duration_ms)
+{
+	animation->durationMs = duration_ms;
+	return(true);
+}
+
+bool animation_set_curve(Animation* animation, AnimationCurve curve)	{ return(true); }
+
+bool animation_set_implementation(Animation* animation, AnimationImplementation const* implementation)
+{
+	animation->implementation = implementation;
+	return(true);
+}
+
+bool animation_set_handlers(Animation* animation, AnimationHandlers callbacks, void* context)
+{
+	animation->handlers = callbacks;
+	animation->context = context;
+	return(true);
+}
+
+bool animation_is_scheduled(Animation* animation)	{ return((animation != 0) && animation->scheduled); }
+
+bool animation_schedule(Animation* animation)
+{
+	if((animation == 0) || animation->scheduled)
+		return(false);
+	animation->scheduled = true;
+	animation->elapsedMs = 0;
+	if((animation->implementation != 0) && (animation->implementation->setup != 0))
+		animation->implementation->setup(animation);
+	if(animation->handlers.started != 0)
+		animation->handlers.started(animation, animation->context);
+	return(true);
+}
+
+// stops the animation, then destroys it
+static void stopAnimation(Animation* animation, bool finished)
+{
+	animation->scheduled = false;
+	if(animation->handlers.stopped != 0)
+		animation->handlers.stopped(animation, finished, animation->context);
+	if((animation->implementation != 0) && (animation->implementation->teardown != 0))
+		animation->implementation->teardown(animation);
+	animation_destroy(animation);
+}
+
+bool animation_unschedule(Animation* animation)
+{
+	if(!animation_is_scheduled(animation))
+		return(false);
+	stopAnimation(animation, false);
+	return(true);
+}
+
+bool hostStepAnimations(uint32_t milliseconds)
+{
+	bool running = false;
+	for(int i = 0; i < kAnimations; i++)
+	{
+		Animation* animation = &gAnimations[i];
+		if(!animation->scheduled)
+			continue;
+
+		animation->elapsedMs += milliseconds;
+		if(animation->elapsedMs > animation->durationMs)
+			animation->elapsedMs = animation->durationMs;
+		AnimationProgress progress = (animation->durationMs > 0)?
+										((uint64_t)animation->elapsedMs * ANIMATION_NORMALIZED_MAX / animation->durationMs)
+										: ANIMATION_NORMALIZED_MAX;
+		if((animation->implementation != 0) && (animation->implementation->update != 0))
+			animation->implementation->update(animation, progress);
+
+		// the update may have unscheduled it
+		if(animation->scheduled && (animation->elapsedMs == animation->durationMs))
+			stopAnimation(animation, true);
+		running |= animation->scheduled;
+	}
+	return(running);
+}
+
+#define kAppTimers 8
+
+struct AppTimer
+{
+	bool				used;
+	int64_t				dueMs;		// on timerClockMs()'s clock
+	AppTimerCallback	callback;
+	void*				data;
+};
+
+static AppTimer gAppTimers[kAppTimers];
+static uint32_t gTimerClockMs = 0;	// how far hostRunTimers has moved on past the second hostTime is at
+
+static int64_t timerClockMs(void)
+{
+	return((int64_t)hostTime(0) * 1000 + gTimerClockMs);
+}
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data)
+{
+	for(int i = 0; i < kAppTimers; i++)
+	{
+		if(gAppTimers[i].used)
+			continue;
+		gAppTimers[i] = (AppTimer){true, timerClockMs() + timeout_ms, callback, callback_data};
+		return(&gAppTimers[i]);
+	}
+	return(0);
+}
+
+void app_timer_cancel(AppTimer* timer)
+{
+	if(timer != 0)
+		timer->used = false;
+}
+
+// fires the timers due by now, earliest first, each once
+static void fireAppTimers(void)
+{
+	int64_t nowMs = timerClockMs();
+	for(;;)
+	{
+		AppTimer* due = 0;
+		for(int i = 0; i < kAppTimers; i++)
+		{
+			if(gAppTimers[i].used && (gAppTimers[i].dueMs <= nowMs) && ((due == 0) || (gAppTimers[i].dueMs < due->dueMs)))
+				due = &gAppTimers[i];
+		}
+		if(due == 0)
+			return;
+		due->used = false;
+		due->callback(due->data);
+	}
+}
+
+void hostSetTime(struct tm const* now)
+{
+	TimeUnits changed = SECOND_UNIT | MINUTE_UNIT | HOUR_UNIT | DAY_UNIT | MONTH_UNIT | YEAR_UNIT;
+	if(gHaveLastTick)
+	{
+		changed = 0;
+		if(now->tm_sec != gLastTick.tm_sec)		changed |= SECOND_UNIT;
+		if(now->tm_min != gLastTick.tm_min)		changed |= MINUTE_UNIT;
+		if(now->tm_hour != gLastTick.tm_hour)	changed |= HOUR_UNIT;
+		if(now->tm_mday != gLastTick.tm_mday)	changed |= DAY_UNIT;
+		if(now->tm_mon != gLastTick.tm_mon)		changed |= MONTH_UNIT;
+		if(now->tm_year != gLastTick.tm_year)	changed |= YEAR_UNIT;
+	}
+	gLastTick = *now;
+	gHaveLastTick = true;
+	gTimerClockMs = 0;
+	fireAppTimers();
+
+	if((gTickHandler != 0) && (changed & gTickUnits))
+	{
+		struct tm t = *now;
+		gTickCount++;
+		gTickHandler(&t, changed);
+	}
+}
+
+uint32_t hostTickCount(void)	{ return(gTickCount); }
+
+void hostRunTimers(uint32_t milliseconds)
+{
+	gTimerClockMs += milliseconds;
+	fireAppTimers();
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler)	{ gTapHandler = handler; }
+void accel_tap_service_unsubscribe(void)					{ gTapHandler = 0; }
+
+void hostTap(AccelAxisType axis, int32_t direction)
+{
+	if(gTapHandler != 0)
+		gTapHandler(axis, direction);
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler)	{ gBatteryHandler = handler; }
+void battery_state_service_unsubscribe(void)						{ gBatteryHandler = 0; }
+BatteryChargeState battery_state_service_peek(void)					{ return(gBatteryState); }
+
+void hostSetBattery(BatteryChargeState charge)
+{
+	gBatteryState = charge;
+	if(gBatteryHandler != 0)
+		gBatteryHandler(charge);
+}
+
+void connection_service_subscribe(ConnectionHandlers handlers)	{ gConnectionHandlers = handlers; }
+void connection_service_unsubscribe(void)						{ gConnectionHandlers = (ConnectionHandlers){0}; }
+bool connection_service_peek_pebble_app_connection(void)		{ return(gConnected); }
+
+void hostSetConnection(bool connected)
+{
+	gConnected = connected;
+	if(gConnectionHandlers.pebble_app_connection_handler != 0)
+		gConnectionHandlers.pebble_app_connection_handler(connected);
+}
+
+// no events: the watchface polls
+HealthServiceAccessibilityMask health_service_metric_accessible(HealthMetric metric, time_t time_start, time_t time_end)
+{
+	return(((metric < HealthMetricCount) && (gHealth[metric] >= 0))? HealthServiceAccessibilityMaskAvailable : HealthServiceAccessibilityMaskNotSupported);
+}
+
+HealthValue health_service_sum_today(HealthMetric metric)			{ return((metric < HealthMetricCount)? gHealth[metric] : 0); }
+HealthValue health_service_peek_current_value(HealthMetric metric)	{ return((metric < HealthMetricCount)? gHealth[metric] : 0); }
+
+void hostSetHealth(HealthMetric metric, HealthValue value)
+{
+	if(metric < HealthMetricCount)
+		gHealth[metric] = value;
+}
+
+time_t time_start_of_today(void)
+{
+	time_t now = hostTime(0);
+	struct tm today = *localtime(&now);
+	today.tm_hour = today.tm_min = today.tm_sec = 0;
+	return(mktime(&today));
+}
+
+void vibes_short_pulse(void)	{ gVibrationCount++; }
+void vibes_double_pulse(void)	{ gVibrationCount++; }
+uint32_t hostVibrationCount(void)	{ return(gVibrationCount); }
+
+char const* i18n_get_system_locale(void)	{ return(gLocale); }
+void hostSetLocale(char const* locale)		{ gLocale = locale; }
+
+////////////////////////////////////////////////////////////////
+// persistent storage
+
+#define kPersistSlots 32
+
+static struct
+{
+	bool		used;
+	uint32_t	key;
+	size_t		size;
+	uint8_t		data[PERSIST_DATA_MAX_LENGTH];
+} gPersist[kPersistSlots];
+
+static uint32_t gPersistWriteCount = 0;
+
+static int persistSlot(uint32_t key, bool create)
+{
+	int freeSlot = -1;
+	for(int i = 0; i < kPersistSlots; i++)
+	{
+		if(gPersist[i].used && (gPersist[i].key == key))
+			return(i);
+		if(!gPersist[i].used && (freeSlot < 0))
+			freeSlot = i;
+	}
+	if(create && (freeSlot >= 0))
+	{
+		gPersist[freeSlot].used = true;
+		gPersist[freeSlot].key = key;
+		gPersist[freeSlot].size = 0;
+		return(freeSlot);
+	}
+	return(-1);
+}
+
+bool persist_exists(uint32_t key)	{ return(persistSlot(key, false) >= 0); }
+
+int persist_read_data(uint32_t key, void* buffer, size_t bufferSize)
+{
+	int slot = persistSlot(key, false);
+	if(slot < 0)
+		return(-1);
+	size_t n = (gPersist[slot].size < bufferSize)? gPersist[slot].size : bufferSize;
+	memcpy(buffer, gPersist[slot].data, n);
+	return((int)n);
+}
+
+int persist_write_data(uint32_t key, void const* data, size_t size)
+{
+	int slot = persistSlot(key, true);
+	if(slot < 0)
+		return(-1);
+	if(size > PERSIST_DATA_MAX_LENGTH)
+		size = PERSIST_DATA_MAX_LENGTH;
+	memcpy(gPersist[slot].data, data, size);
+	gPersist[slot].size = size;
+	gPersistWriteCount++;
+	return((int)size);
+}
+
+int32_t persist_read_int(uint32_t key)
+{
+	int32_t value = 0;
+	persist_read_data(key, &value, sizeof(value));
+	return(value);
+}
+
+int persist_write_int(uint32_t key, int32_t value)
+{
+	return(persist_write_data(key, &value, sizeof(value)));
+}
+
+int persist_delete(uint32_t key)
+{
+	int slot = persistSlot(key, false);
+	if(slot >= 0)
+		gPersist[slot].used = false;
+	return(0);
+}
+
+uint32_t hostPersistWriteCount(void)	{ return(gPersistWriteCount); }
+
+////////////////////////////////////////////////////////////////
+// app messages
+//
+// A serialized dictionary is a one-byte tuple count followed by packed Tuples.
+
+Tuple* dict_read_first(DictionaryIterator* it)
+{
+	it->cursor = (Tuple*)(it->dictionary + 1);
+	return(((uint8_t const*)it->cursor < it->end)? it->cursor : 0);
+}
+
+Tuple* dict_read_next(DictionaryIterator* it)
+{
+	it->cursor = (Tuple*)((uint8_t*)it->cursor + sizeof(Tuple) + it->cursor->length);
+	return(((uint8_t const*)it->cursor < it->end)? it->cursor : 0);
+}
+
+Tuple* dict_find(DictionaryIterator const* it, uint32_t key)
+{
+	DictionaryIterator scan = *it;
+	for(Tuple* t = dict_read_first(&scan); t != 0; t = dict_read_next(&scan))
+		if(t->key == key)
+			return(t);
+	return(0);
+}
+
+uint32_t dict_calc_buffer_size(uint8_t const tupleCount, ...)
+{
+	uint32_t size = 1 + (tupleCount * sizeof(Tuple));
+	va_list sizes;
+	va_start(sizes, tupleCount);
+	for(uint8_t i = 0; i < tupleCount; i++)
+		size += va_arg(sizes, uint32_t);
+	va_end(sizes);
+	return(size);
+}
+
+AppMessageResult app_message_open(uint32_t sizeInbound, uint32_t sizeOutbound)
+{
+	heapAllocated(&gHeap.appMessageBytes, &gHeap.peakAppMessageBytes, sizeInbound + sizeOutbound);
+	gInboxSize = sizeInbound;
+	return(APP_MSG_OK);
+}
+
+void hostReceiveAppMessage(uint32_t key, uint8_t const* data, uint16_t length)
+{
+	uint8_t dictionary[1 + sizeof(Tuple) + PERSIST_DATA_MAX_LENGTH];
+	uint32_t size = dict_calc_buffer_size(1, (uint32_t)length);
+	if((size > gInboxSize) || (size > sizeof(dictionary)))
+	{
+		if(gInboxDropped != 0)
+			gInboxDropped(APP_MSG_BUFFER_OVERFLOW, 0);
+		return;
+	}
+
+	Tuple* tuple = (Tuple*)(dictionary + 1);
+	dictionary[0] = 1;
+	tuple->key = key;
+	tuple->type = TUPLE_BYTE_ARRAY;
+	tuple->length = length;
+	memcpy(tuple->value->data, data, length);
+
+	DictionaryIterator it = {dictionary, dictionary + size, 0};
+	if(gInboxReceived != 0)
+		gInboxReceived(&it, 0);
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived callback)
+{
+	AppMessageInboxReceived previous = gInboxReceived;
+	gInboxReceived = callback;
+	return(previous);
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped callback)
+{
+	AppMessageInboxDropped previous = gInboxDropped;
+	gInboxDropped = callback;
+	return(previous);
+}
+
+////////////////////////////////////////////////////////////////
+// logging and the event loop
+
+void app_log(uint8_t level, char const* filename, int lineNumber, char const* fmt, ...)
+{
+	fprintf(stderr, "[%u] %s:%d> ", level, filename, lineNumber);
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fputc('\n', stderr);
+}
+
+// the harness owns the event loop, so the app's call returns immediately
+void app_event_loop(void)
+{
+	;
+}
+
+void hostRelaunch(void)
+{
+	if(gTopWindow != 0)
+	{
+		Window* window = gTopWindow;
+		if(window->handlers.disappear != 0)
+			window->handlers.disappear(window);
+		if(window->handlers.unload != 0)
+			window->handlers.unload(window);
+		for(Layer* layer = window->root.firstChild; layer != 0; )
+		{
+			Layer* next = layer->nextSibling;
+			layer_destroy(layer);
+			layer = next;
+		}
+		window_destroy(window);
+	}
+
+	for(int i = 0; i < kAppTimers; i++)
+		gAppTimers[i].used = false;
+	gTimerClockMs = 0;
+	for(int i = 0; i < kAnimations; i++)
+		animation_destroy(&gAnimations[i]);
+	gTickHandler = 0;
+	gTapHandler = 0;
+	gBatteryHandler = 0;
+	gConnectionHandlers = (ConnectionHandlers){0};
+	gInboxReceived = 0;
+	gInboxDropped = 0;
+	heapAllocated(&gHeap.appMessageBytes, &gHeap.peakAppMessageBytes, -(int32_t)gHeap.appMessageBytes);
+
+	// blank, as the framebuffer starts out, so nothing of the last frame shows through
+	memset(gFrameBuffer, 0, sizeof(gFrameBuffer));
+	memset(gPixelBlended, 0, sizeof(gPixelBlended));
+	pebbleMain();
+}
@@ -0,0 +1,373 @@
+// Render benchmark: boots the watchface against the host SDK, then ticks through a simulated
+// day one minute at a time and reports render time, pixels written, draw calls and trig lookups
+// per layer, overdraw (pixels written per distinct pixel written), and the heap and stack the
+// watchface used.
+//
+//	usage: render_bench [-m minutes] [-l locale] [-q start,end,interval] [-s top,left,right,bottom,zone]
+//						[-c] [-f] [-o last-frame.ppm]
+//
+// -f prints every frame's overdraw.
+//
+// -q sets quiet hours (from the start hour to the end hour, redrawing every interval minutes) and
+// reports the minute ticks they saved a render.
+//
+// -s binds the complication slots to sources (the watchface's kSource* numbers), with the second
+// time zone zone quarter hours from UTC, and has HealthService report a step count that climbs
+// and a heart rate that wanders every minute.  A slot bound to the weekday, month or date is
+// drawn into the face's complication cache, so with -c, binding the bottom one (which takes the
+// battery's color) to one of them checks that the cache follows a color change.
+//
+// The face's opening sweep is stepped a frame every kAnimationFrameMs before the day starts.
+//
+// -c checks every frame against a full repaint of the same state, forced by making the window
+// disappear and appear again (which also drops the face's caches), and counts mismatched pixels.
+// The repaint is drawn with the framebuffer refused to contexts that antialias, so it's the face as
+// the SDK alone draws it, and pixels blended in either frame, whose colors depend on what was under
+// them, aren't counted; every frame also counts the pixels written straight into the framebuffer
+// over edges antialiased earlier in it.  It also delivers a few configuration changes, taps
+// (stepping through the seconds bursts they start), a draining battery and a flapping connection
+// along the way, so their partial repaints are checked.
+
+#include "host.h"
+
+#include <stdlib.h>
+
+// layer names, in the order onWindowLoad stacks them
+static char const* const kLayerNames[] = {"face"};
+
+// configuration messages (KEY_CONFIG, version 1) the check delivers, one every kConfigInterval minutes
+enum { kKeyConfig = 17, kKeyQuietHours = 18, kKeyComplications = 19, kConfigInterval = 97 };
+static uint8_t const kConfigChanges[][3] =
+{
+	{1, 11, 0xFC},	// battery color
+	{1, 0, 0xF0},	// outer ring
+	{1, 3, 0xC3},	// inner ring background
+	{1, 6, 0xCC},	// hour hand
+	{1, 5, 0xC0},	// innermost text
+	{1, 7, 0xF3},	// minute hand
+	{1, 10, 0xE0},	// day complication
+	{1, 15, 0xFE},	// background
+	{1, 16, 0xD7},	// outer background
+};
+
+// the animation timer's period
+enum { kAnimationFrameMs = 33 };
+
+// how long the events before a frame are given to settle: longer than the face gathers redraws
+enum { kSettleMs = 100 };
+
+// a tap kBurstLead seconds before the minute, every kBurstInterval minutes, and seconds up to it
+enum { kBurstInterval = 180, kBurstLead = 10 };
+
+// the battery drops kBatteryStep percent every kBatteryInterval minutes, each level reported twice
+enum { kBatteryInterval = 150, kBatteryStep = 10 };
+
+// every kConnectionInterval minutes the connection drops kConnectionDropSecond seconds before the
+// minute: for kConnectionFlapSeconds, then, every other time, until the next interval
+enum { kConnectionInterval = 200, kConnectionDropSecond = 40, kConnectionFlapSeconds = 3 };
+
+typedef struct LayerTotals
+{
+	uint32_t	renders;
+	uint64_t	nanoseconds,
+				minNanoseconds,
+				maxNanoseconds;
+	uint64_t	pixelsWritten,
+				drawCalls,
+				textLayouts,
+				trigLookups;
+	uint32_t	maxStackBytes;
+} LayerTotals;
+
+static bool gCheck = false, gPrintFrames = false;
+static LayerTotals gTotals[HOST_MAX_LAYERS];
+static uint32_t gFrames = 0, gMismatchedFrames = 0, gOverwritingFrames = 0;
+static uint64_t gFrameNanoseconds = 0, gPixelsWritten = 0, gPixelsCovered = 0;
+static double gMaxOverdraw = 0;
+
+static char const* layerName(uint32_t index)
+{
+	return((index < sizeof(kLayerNames) / sizeof(kLayerNames[0]))? kLayerNames[index] : "?");
+}
+
+static double overdraw(HostFrameStats const* frame)
+{
+	return((frame->pixelsCovered > 0)? ((double)frame->draw.pixelsWritten / frame->pixelsCovered) : 0);
+}
+
+static void printFrame(char const* title, HostFrameStats const* frame)
+{
+	printf("%s\n", title);
+	printf("  %-14s %10s %10s %8s %8s %8s\n", "layer", "us", "pixels", "draws", "texts", "trig");
+	for(uint32_t i = 0; i < frame->layerCount; i++)
+	{
+		HostLayerStats const* s = &frame->layers[i];
+		printf(	"  %-14s %10.1f %10u %8u %8u %8u\n", layerName(i), s->renderNanoseconds / 1000.0,
+				s->draw.pixelsWritten, s->draw.drawCalls, s->draw.textLayouts, s->draw.trigLookups
+			);
+	}
+	printf(	"  %-14s %10.1f %10u %8u %8u %8u\n", "frame", frame->renderNanoseconds / 1000.0,
+			frame->draw.pixelsWritten, frame->draw.drawCalls, frame->draw.textLayouts, frame->draw.trigLookups
+		);
+	printf("  overdraw %.2f (%u pixels covered)\n\n", overdraw(frame), frame->pixelsCovered);
+}
+
+// with -c, counts a frame that wrote hard edges straight into the framebuffer over antialiased ones
+static void checkAntialiasing(struct tm const* now, HostFrameStats const* frame)
+{
+	if(!gCheck || (frame->antialiasingOverwritten == 0))
+		return;
+	gOverwritingFrames++;
+	printf(	"  %02d:%02d:%02d: %u antialiased pixels written over with hard edges\n",
+			now->tm_hour, now->tm_min, now->tm_sec, frame->antialiasingOverwritten
+		);
+}
+
+// renders a frame if the face asked for one, accumulating its statistics and (with -c) comparing
+// it with a full repaint; returns whether it did
+static bool renderFrame(struct tm const* now)
+{
+	HostFrameStats frame;
+	hostRunTimers(kSettleMs);
+	if(!hostRenderFrame(&frame))
+		return(false);
+
+	gFrames++;
+	checkAntialiasing(now, &frame);
+	gFrameNanoseconds += frame.renderNanoseconds;
+	gPixelsWritten += frame.draw.pixelsWritten;
+	gPixelsCovered += frame.pixelsCovered;
+	if(overdraw(&frame) > gMaxOverdraw)
+		gMaxOverdraw = overdraw(&frame);
+	if(gPrintFrames)
+	{
+		printf(	"  %02d:%02d:%02d: %u pixels written, %u covered, overdraw %.2f\n", now->tm_hour, now->tm_min, now->tm_sec,
+				frame.draw.pixelsWritten, frame.pixelsCovered, overdraw(&frame)
+			);
+	}
+	for(uint32_t i = 0; i < frame.layerCount; i++)
+	{
+		HostLayerStats const* s = &frame.layers[i];
+		LayerTotals* t = &gTotals[i];
+		if((t->renders == 0) || (s->renderNanoseconds < t->minNanoseconds))
+			t->minNanoseconds = s->renderNanoseconds;
+		if(s->renderNanoseconds > t->maxNanoseconds)
+			t->maxNanoseconds = s->renderNanoseconds;
+		if(s->stackBytes > t->maxStackBytes)
+			t->maxStackBytes = s->stackBytes;
+		t->renders++;
+		t->nanoseconds += s->renderNanoseconds;
+		t->pixelsWritten += s->draw.pixelsWritten;
+		t->drawCalls += s->draw.drawCalls;
+		t->textLayouts += s->draw.textLayouts;
+		t->trigLookups += s->draw.trigLookups;
+	}
+
+	if(gCheck)
+	{
+		static uint8_t rendered[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+		static bool blended[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+		memcpy(rendered, hostFrameBuffer(), sizeof(rendered));
+		memcpy(blended, hostBlendedPixels(), sizeof(blended));
+		hostRefuseAntialiasedCapture(true);
+		hostRedisplayWindow();
+		hostRenderFrame(0);
+		hostRefuseAntialiasedCapture(false);
+
+		uint32_t mismatched = 0;
+		for(size_t p = 0; p < sizeof(rendered); p++)
+			mismatched += (rendered[p] != hostFrameBuffer()[p]) && !blended[p] && !hostBlendedPixels()[p];
+		if(mismatched > 0)
+		{
+			gMismatchedFrames++;
+			printf(	"  %02d:%02d:%02d: %u pixels differ from a full repaint\n",
+					now->tm_hour, now->tm_min, now->tm_sec, mismatched
+				);
+		}
+
+		// the next frame goes on from a full repaint as the face would draw it
+		hostRedisplayWindow();
+		hostRenderFrame(&frame);
+		checkAntialiasing(now, &frame);
+	}
+	return(true);
+}
+
+int main(int argc, char** argv)
+{
+	int minutes = 24 * 60, quietStart = 0, quietEnd = 0, quietInterval = 0;
+	int slots[5] = {0}, slotCount = 0;
+	char const* framePath = 0;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if((strcmp(argv[i], "-m") == 0) && (i + 1 < argc))
+			minutes = atoi(argv[++i]);
+		else if((strcmp(argv[i], "-l") == 0) && (i + 1 < argc))
+			hostSetLocale(argv[++i]);
+		else if((strcmp(argv[i], "-q") == 0) && (i + 1 < argc))
+			sscanf(argv[++i], "%d,%d,%d", &quietStart, &quietEnd, &quietInterval);
+		else if((strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+			slotCount = sscanf(argv[++i], "%d,%d,%d,%d,%d", &slots[0], &slots[1], &slots[2], &slots[3], &slots[4]);
+		else if(strcmp(argv[i], "-c") == 0)
+			gCheck = true;
+		else if(strcmp(argv[i], "-f") == 0)
+			gPrintFrames = true;
+		else if((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+			framePath = argv[++i];
+		else
+		{
+			fprintf(	stderr, "usage: %s [-m minutes] [-l locale] [-q start,end,interval] [-s top,left,right,bottom,zone] "
+						"[-c] [-f] [-o last-frame.ppm]\n", argv[0]
+					);
+			return(1);
+		}
+	}
+
+	pebbleMain();
+
+	if(quietInterval > 0)
+	{
+		uint8_t const quietHours[] = {1, kKeyQuietHours, quietStart, quietEnd, quietInterval, 0};
+		hostReceiveAppMessage(kKeyConfig, quietHours, sizeof(quietHours));
+	}
+	if(slotCount >= 4)
+	{
+		uint8_t const complications[] = {1, kKeyComplications, slots[0] | (slots[1] << 4), slots[2] | (slots[3] << 4), slots[4], 0};
+		hostReceiveAppMessage(kKeyConfig, complications, sizeof(complications));
+	}
+
+	HostFrameStats frame;
+	hostRunTimers(kSettleMs);
+	hostRenderFrame(&frame);
+	printFrame("first frame (window appear)", &frame);
+
+	// a fixed, ordinary day so runs are comparable
+	struct tm now = {.tm_year = 116, .tm_mon = 2, .tm_mday = 4, .tm_wday = 5, .tm_hour = 0, .tm_min = 0};
+
+	uint32_t sweepFrames = gFrames;
+	while(hostStepAnimations(kAnimationFrameMs))
+		renderFrame(&now);
+	renderFrame(&now);
+	sweepFrames = gFrames - sweepFrames;
+
+	int quietMinutes = 0;	// minute ticks that rendered nothing
+	for(int m = 0; m < minutes; m++)
+	{
+		int change = m / kConfigInterval - 1;
+		if(gCheck && (m % kConfigInterval == 0) && (change >= 0) && (change < (int)(sizeof(kConfigChanges) / sizeof(kConfigChanges[0]))))
+			hostReceiveAppMessage(kKeyConfig, kConfigChanges[change], sizeof(kConfigChanges[change]));
+
+		if(gCheck && (m % kBatteryInterval == kBatteryInterval - 1))
+		{
+			BatteryChargeState charge = {.charge_percent = 100 - kBatteryStep * (1 + m / kBatteryInterval)};
+			hostSetBattery(charge);
+			hostSetBattery(charge);
+		}
+
+		if(gCheck && (m % kConnectionInterval == kConnectionInterval - 1))
+		{
+			struct tm second = now;
+			second.tm_min--;
+			second.tm_sec = 60 - kConnectionDropSecond;
+			mktime(&second);
+			hostSetTime(&second);
+			if(!connection_service_peek_pebble_app_connection())
+				hostSetConnection(true);
+			else
+			{
+				hostSetConnection(false);
+				if((m / kConnectionInterval) % 2 == 0)
+				{
+					second.tm_sec += kConnectionFlapSeconds;
+					hostSetTime(&second);
+					hostSetConnection(true);
+				}
+			}
+			renderFrame(&second);
+		}
+
+		if(gCheck && (m % kBurstInterval == kBurstInterval - 1))
+		{
+			struct tm second = now;
+			second.tm_min--;
+			second.tm_sec = 60 - kBurstLead;
+			mktime(&second);
+			hostSetTime(&second);
+			hostTap(ACCEL_AXIS_Z, 1);
+			for(int s = 1; s < kBurstLead; s++)
+			{
+				second.tm_sec++;
+				hostSetTime(&second);
+				renderFrame(&second);
+			}
+		}
+
+		if(slotCount >= 4)
+		{
+			hostSetHealth(HealthMetricStepCount, 37 * m);
+			hostSetHealth(HealthMetricHeartRateBPM, 60 + (m * 7) % 31);
+		}
+
+		hostSetTime(&now);
+		if(!renderFrame(&now))
+			quietMinutes++;
+
+		// advance one minute, letting mktime carry into hours, days and months
+		now.tm_min++;
+		mktime(&now);
+	}
+
+	printf("%d simulated minutes, %u frames rendered (%u of them the opening sweep)\n", minutes, gFrames, sweepFrames);
+	printf(	"  %-14s %8s %10s %10s %10s %10s %8s %8s %8s %8s\n",
+			"layer", "renders", "avg us", "min us", "max us", "pixels", "draws", "texts", "trig", "stack"
+		);
+	for(uint32_t i = 0; i < HOST_MAX_LAYERS; i++)
+	{
+		LayerTotals const* t = &gTotals[i];
+		if(t->renders == 0)
+			continue;
+		printf(	"  %-14s %8u %10.2f %10.2f %10.2f %10.1f %8.2f %8.2f %8.2f %8u\n", layerName(i), t->renders,
+				t->nanoseconds / 1000.0 / t->renders, t->minNanoseconds / 1000.0, t->maxNanoseconds / 1000.0,
+				(double)t->pixelsWritten / t->renders, (double)t->drawCalls / t->renders, (double)t->textLayouts / t->renders,
+				(double)t->trigLookups / t->renders, t->maxStackBytes
+			);
+	}
+	if(gFrames > 0)
+		printf("  %-14s %8u %10.2f\n", "frame", gFrames, gFrameNanoseconds / 1000.0 / gFrames);
+
+	uint64_t totalPixels = 0, totalTexts = 0, totalTrig = 0;
+	uint32_t maxStackBytes = 0;
+	for(uint32_t i = 0; i < HOST_MAX_LAYERS; i++)
+	{
+		totalPixels += gTotals[i].pixelsWritten;
+		totalTexts += gTotals[i].textLayouts;
+		totalTrig += gTotals[i].trigLookups;
+		if(gTotals[i].maxStackBytes > maxStackBytes)
+			maxStackBytes = gTotals[i].maxStackBytes;
+	}
+	printf(	"totals: %llu pixels written, %llu text layouts, %llu trig lookups\n",
+			(unsigned long long)totalPixels, (unsigned long long)totalTexts, (unsigned long long)totalTrig
+		);
+	if(gPixelsCovered > 0)
+		printf("overdraw: %.2f writes per pixel covered, %.2f at most\n", (double)gPixelsWritten / gPixelsCovered, gMaxOverdraw);
+	HostHeapStats heap = hostHeapStats();
+	printf(	"heap: %u bytes at peak: %u in windows, layers and animations, %u in bitmaps, %u in AppMessage buffers\n",
+			heap.peakBytes, heap.peakLayerBytes, heap.peakBitmapBytes, heap.peakAppMessageBytes
+		);
+	printf("stack: %u bytes at most in an update proc\n", maxStackBytes);
+	if(quietInterval > 0)
+		printf("quiet hours: %d of %d minute ticks saved a render\n", quietMinutes, minutes);
+	if(gCheck)
+	{
+		printf("%u of %u frames differ from a full repaint\n", gMismatchedFrames, gFrames);
+		printf("%u of %u frames write over antialiased edges\n", gOverwritingFrames, gFrames);
+	}
+
+	if((framePath != 0) && !hostWriteFrameBuffer(framePath))
+	{
+		fprintf(stderr, "could not write %s\n", framePath);
+		return(1);
+	}
+	return(((gMismatchedFrames > 0) || (gOverwritingFrames > 0))? 2 : 0);
+}
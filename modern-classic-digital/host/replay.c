@@ -0,0 +1,503 @@
+// Replay driver: boots the watchface against the host SDK and feeds it a day, a week or a year of
+// events as fast as it can render them, then reports per simulated day the frames rendered,
+// pixels written and the energy a simple model puts on them, and what caused it all.
+//
+//	usage: replay [-d days] [-b yyyy-mm-dd] [-z tz] [-t trace] [-w trace]
+//
+// The events come from a trace: one per line, a UTC time then what happened,
+//
+//	2016-10-31T08:15:03Z tap
+//	2016-10-31T09:00:00Z battery 80 [charging] [plugged]
+//	2016-10-31T10:12:40Z connection 0
+//
+// with '#' starting a comment.  Minute ticks aren't in the trace: the clock runs from local
+// midnight on the first day to the end of the last, ticking every minute (and every second for a
+// minute after each event, so the face's seconds and timers run as they would).  A second's tick
+// and events are one burst, given kSettleMs for the face to gather its redraws into a frame, which
+// is put down to the first of them.  -t replays a recorded trace, over the days it covers unless
+// -b and -d say otherwise; without it a synthetic one is made up for the days asked for, which -w
+// saves.  The clock is local to -z, a POSIX TZ (by default US Eastern, with its DST rules), and
+// the default start, 2016-10-31, takes a week's replay across a month's end and the end of DST.
+//
+// The energy model prices what the host can count rather than what it can time, so a build's
+// figure is the same on every run: a fixed cost to wake for each event or tick delivered, one to
+// send each frame to the display, and one per pixel written, draw call, text layout and trig
+// lookup, plus vibrations and flash writes.  The costs are rough guesses at a Pebble's, in
+// microjoules; what matters is that a change that does less work costs less.
+
+#include "host.h"
+
+#include <stdlib.h>
+
+// microjoules for each thing the model prices
+static double const kEnergyWake = 60;			// the CPU out of sleep and through a handler
+static double const kEnergyFrame = 250;			// the framebuffer out to the display
+static double const kEnergyPixel = 0.02;
+static double const kEnergyDrawCall = 0.5;
+static double const kEnergyTextLayout = 8;
+static double const kEnergyTrigLookup = 0.05;
+static double const kEnergyVibration = 35000;	// a pulse of the vibration motor
+static double const kEnergyPersistWrite = 400;	// a flash sector write
+
+// how long a burst of events is given to settle before its frame: longer than the face gathers
+// redraws
+enum { kSettleMs = 100 };
+
+// what a wake and its frame are put down to
+typedef enum
+{
+	kCauseAppear,
+	kCauseSweep,		// the animation the face opens with
+	kCauseMinute,
+	kCauseSecond,		// a tick between minutes, as after a tap
+	kCauseMidnight,		// a tick that starts a new day
+	kCauseClockChange,	// a tick that skips or repeats an hour, for DST
+	kCauseTimer,		// an AppTimer that fired between events
+	kCauseTap,
+	kCauseBattery,
+	kCauseConnection,
+	kCauseCount,
+} Cause;
+
+static char const* const kCauseNames[kCauseCount] =
+{
+	"appear", "sweep", "minute", "second", "midnight", "clock change", "timer", "tap", "battery", "connection",
+};
+
+typedef enum
+{
+	kEventTap,
+	kEventBattery,
+	kEventConnection,
+} EventType;
+
+typedef struct Event
+{
+	time_t		time;
+	EventType	type;
+	int			value;		// battery percent, or whether connected
+	bool		charging,
+				plugged;
+} Event;
+
+typedef struct Totals
+{
+	uint32_t	wakes,
+				frames;
+	uint64_t	pixelsWritten,
+				drawCalls,
+				textLayouts,
+				trigLookups;
+	uint32_t	vibrations,
+				persistWrites;
+	double		microjoules;
+} Totals;
+
+static Event* gEvents = 0;
+static size_t gEventCount = 0, gEventCapacity = 0;
+
+static Totals gCauses[kCauseCount];
+static Totals gDay;
+
+static void addEvent(Event event)
+{
+	if(gEventCount == gEventCapacity)
+	{
+		gEventCapacity = (gEventCapacity > 0)? (gEventCapacity * 2) : 256;
+		gEvents = realloc(gEvents, gEventCapacity * sizeof(Event));
+		if(gEvents == 0)
+		{
+			fprintf(stderr, "out of memory for the trace\n");
+			exit(1);
+		}
+	}
+	gEvents[gEventCount++] = event;
+}
+
+static int compareEvents(void const* a, void const* b)
+{
+	time_t const ta = ((Event const*)a)->time, tb = ((Event const*)b)->time;
+	return((ta < tb)? -1 : (ta > tb));
+}
+
+// local midnight at the start of the day holding when, or days after it
+static time_t localMidnight(time_t when, int days)
+{
+	struct tm day;
+	localtime_r(&when, &day);
+	day.tm_hour = day.tm_min = day.tm_sec = 0;
+	day.tm_mday += days;
+	day.tm_isdst = -1;
+	return(mktime(&day));
+}
+
+// a small deterministic generator, so synthetic traces are the same on every run
+static uint32_t gRandom = 1;
+
+static uint32_t randomBelow(uint32_t limit)
+{
+	gRandom = gRandom * 1103515245 + 12345;
+	return((gRandom >> 16) % limit);
+}
+
+// a made-up but ordinary life for the watch: a dozen glances a day while awake, the phone out of
+// range twice a day for up to half an hour, and a battery that loses 10% every 16 hours and is
+// charged at 21:00 once it reaches 20%
+static void syntheticTrace(time_t start, time_t end)
+{
+	for(time_t day = start; day < end; day = localMidnight(day, 1))
+	{
+		for(int tap = 0; tap < 12; tap++)
+			addEvent((Event){.time = day + 7 * 3600 + randomBelow(16 * 3600), .type = kEventTap});
+		for(int drop = 0; drop < 2; drop++)
+		{
+			time_t down = day + drop * 12 * 3600 + randomBelow(11 * 3600);
+			addEvent((Event){.time = down, .type = kEventConnection, .value = 0});
+			addEvent((Event){.time = down + 5 + randomBelow(30 * 60), .type = kEventConnection, .value = 1});
+		}
+	}
+
+	int level = 100;
+	bool charging = false;
+	time_t changed = start;
+	for(time_t t = start; t < end; t += 60)
+	{
+		struct tm local;
+		localtime_r(&t, &local);
+		if(!charging && (level <= 20) && (local.tm_hour == 21) && (local.tm_min == 0))
+			charging = true;
+		else if(!charging && (t - changed >= 16 * 3600))
+			level -= 10;
+		else if(charging && (t - changed >= 12 * 60))
+			level += 10;
+		else
+			continue;
+
+		changed = t;
+		addEvent((Event){.time = t, .type = kEventBattery, .value = level, .charging = charging && (level < 100), .plugged = charging});
+		if(charging && (level == 100))
+		{
+			charging = false;
+			addEvent((Event){.time = t + 30 * 60, .type = kEventBattery, .value = level});
+		}
+	}
+}
+
+static bool readTrace(char const* path)
+{
+	FILE* file = fopen(path, "r");
+	if(file == 0)
+		return(false);
+
+	char line[256];
+	for(int number = 1; fgets(line, sizeof(line), file) != 0; number++)
+	{
+		char* comment = strchr(line, '#');
+		if(comment != 0)
+			*comment = 0;
+
+		struct tm utc = {0};
+		char type[16] = "", flag1[16] = "", flag2[16] = "";
+		int value = 0;
+		int fields = sscanf(	line, "%d-%d-%dT%d:%d:%dZ %15s %d %15s %15s", &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+								&utc.tm_hour, &utc.tm_min, &utc.tm_sec, type, &value, flag1, flag2
+							);
+		if(fields <= 0)
+			continue;
+
+		utc.tm_year -= 1900;
+		utc.tm_mon--;
+		Event event = {.time = timegm(&utc), .value = value};
+		if((fields == 7) && (strcmp(type, "tap") == 0))
+			event.type = kEventTap;
+		else if((fields >= 8) && (strcmp(type, "battery") == 0))
+		{
+			event.type = kEventBattery;
+			event.charging = (strcmp(flag1, "charging") == 0) || (strcmp(flag2, "charging") == 0);
+			event.plugged = (strcmp(flag1, "plugged") == 0) || (strcmp(flag2, "plugged") == 0);
+		}
+		else if((fields == 8) && (strcmp(type, "connection") == 0))
+			event.type = kEventConnection;
+		else
+		{
+			fprintf(stderr, "%s:%d: not an event\n", path, number);
+			fclose(file);
+			return(false);
+		}
+		addEvent(event);
+	}
+	fclose(file);
+	return(true);
+}
+
+static bool writeTrace(char const* path)
+{
+	FILE* file = fopen(path, "w");
+	if(file == 0)
+		return(false);
+
+	for(size_t i = 0; i < gEventCount; i++)
+	{
+		Event const* e = &gEvents[i];
+		struct tm utc;
+		gmtime_r(&e->time, &utc);
+		fprintf(	file, "%04d-%02d-%02dT%02d:%02d:%02dZ ", utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday,
+					utc.tm_hour, utc.tm_min, utc.tm_sec
+				);
+		switch(e->type)
+		{
+		case kEventTap:			fprintf(file, "tap\n");									break;
+		case kEventConnection:	fprintf(file, "connection %d\n", e->value);				break;
+		case kEventBattery:
+			fprintf(file, "battery %d%s%s\n", e->value, e->charging? " charging" : "", e->plugged? " plugged" : "");
+			break;
+		}
+	}
+	return(fclose(file) == 0);
+}
+
+static void addTotals(Totals* to, Totals const* from)
+{
+	to->wakes += from->wakes;
+	to->frames += from->frames;
+	to->pixelsWritten += from->pixelsWritten;
+	to->drawCalls += from->drawCalls;
+	to->textLayouts += from->textLayouts;
+	to->trigLookups += from->trigLookups;
+	to->vibrations += from->vibrations;
+	to->persistWrites += from->persistWrites;
+	to->microjoules += from->microjoules;
+}
+
+// what the frame a burst of events asks for is put down to: the first of them, or the timer that
+// fired between events without one
+static Cause gFrameCause = kCauseCount;
+
+// puts step, and the side effects since the last call, down to cause
+static void charge(Cause cause, Totals step)
+{
+	static uint32_t vibrations = 0, persistWrites = 0;
+
+	step.vibrations = hostVibrationCount() - vibrations;
+	step.persistWrites = hostPersistWriteCount() - persistWrites;
+	vibrations = hostVibrationCount();
+	persistWrites = hostPersistWriteCount();
+
+	step.microjoules =	step.wakes * kEnergyWake + step.frames * kEnergyFrame + step.pixelsWritten * kEnergyPixel
+						+ step.drawCalls * kEnergyDrawCall + step.textLayouts * kEnergyTextLayout
+						+ step.trigLookups * kEnergyTrigLookup + step.vibrations * kEnergyVibration
+						+ step.persistWrites * kEnergyPersistWrite;
+	addTotals(&gCauses[cause], &step);
+	addTotals(&gDay, &step);
+}
+
+// puts the wakes and their side effects down to cause
+static void account(Cause cause, uint32_t wakes)
+{
+	charge(cause, (Totals){.wakes = wakes});
+	if((wakes > 0) && (gFrameCause == kCauseCount))
+		gFrameCause = cause;
+}
+
+// lets the face's timers run out the burst, then renders the frame it asked for, if any
+static void flush(void)
+{
+	hostRunTimers(kSettleMs);
+
+	HostFrameStats frame;
+	if(hostRenderFrame(&frame))
+	{
+		charge(	(gFrameCause != kCauseCount)? gFrameCause : kCauseTimer,
+				(Totals){	.frames = 1, .pixelsWritten = frame.draw.pixelsWritten, .drawCalls = frame.draw.drawCalls,
+							.textLayouts = frame.draw.textLayouts, .trigLookups = frame.draw.trigLookups	}
+			);
+	}
+	gFrameCause = kCauseCount;
+}
+
+// moves the clock to when, delivering the tick that brings, and accounts for what it did
+static void setClock(time_t when, struct tm* last)
+{
+	struct tm now;
+	localtime_r(&when, &now);
+
+	Cause cause = kCauseSecond;
+	if(now.tm_mday != last->tm_mday)
+		cause = kCauseMidnight;
+	else if(now.tm_gmtoff != last->tm_gmtoff)
+		cause = kCauseClockChange;
+	else if(now.tm_min != last->tm_min)
+		cause = kCauseMinute;
+	*last = now;
+
+	uint32_t ticks = hostTickCount();
+	hostSetTime(&now);
+	ticks = hostTickCount() - ticks;
+	account((ticks > 0)? cause : kCauseTimer, ticks);
+}
+
+static void deliver(Event const* e)
+{
+	switch(e->type)
+	{
+	case kEventTap:
+		hostTap(ACCEL_AXIS_Z, 1);
+		account(kCauseTap, 1);
+		break;
+	case kEventBattery:
+		hostSetBattery((BatteryChargeState){.charge_percent = e->value, .is_charging = e->charging, .is_plugged = e->plugged});
+		account(kCauseBattery, 1);
+		break;
+	case kEventConnection:
+		hostSetConnection(e->value != 0);
+		account(kCauseConnection, 1);
+		break;
+	}
+}
+
+static void printTotals(char const* title, Totals const* t, double days)
+{
+	printf(	"  %-12s %8.1f %8.1f %12.1f %10.1f %8.1f %10.1f %6.2f %10.2f\n", title, t->wakes / days, t->frames / days,
+			t->pixelsWritten / days, t->drawCalls / days, t->textLayouts / days, t->trigLookups / days,
+			t->vibrations / days, t->microjoules / 1000 / days
+		);
+}
+
+int main(int argc, char** argv)
+{
+	int days = 0;
+	char const* startDate = 0, * zone = "EST5EDT,M3.2.0,M11.1.0", * tracePath = 0, * writePath = 0;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if((strcmp(argv[i], "-d") == 0) && (i + 1 < argc))
+			days = atoi(argv[++i]);
+		else if((strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			startDate = argv[++i];
+		else if((strcmp(argv[i], "-z") == 0) && (i + 1 < argc))
+			zone = argv[++i];
+		else if((strcmp(argv[i], "-t") == 0) && (i + 1 < argc))
+			tracePath = argv[++i];
+		else if((strcmp(argv[i], "-w") == 0) && (i + 1 < argc))
+			writePath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [-d days] [-b yyyy-mm-dd] [-z tz] [-t trace] [-w trace]\n", argv[0]);
+			return(1);
+		}
+	}
+	setenv("TZ", zone, 1);
+	tzset();
+
+	if((tracePath != 0) && !readTrace(tracePath))
+	{
+		fprintf(stderr, "could not read %s\n", tracePath);
+		return(1);
+	}
+	qsort(gEvents, gEventCount, sizeof(Event), compareEvents);
+
+	// the days to replay: those asked for, or those the trace covers
+	struct tm first = {.tm_year = 116, .tm_mon = 9, .tm_mday = 31, .tm_isdst = -1};
+	if(startDate != 0)
+	{
+		sscanf(startDate, "%d-%d-%d", &first.tm_year, &first.tm_mon, &first.tm_mday);
+		first.tm_year -= 1900;
+		first.tm_mon--;
+	}
+	time_t start = mktime(&first), end;
+	if((startDate == 0) && (gEventCount > 0))
+		start = localMidnight(gEvents[0].time, 0);
+	if((days <= 0) && (gEventCount > 0))
+	{
+		end = localMidnight(gEvents[gEventCount - 1].time, 1);
+		for(time_t day = start; day < end; day = localMidnight(day, 1))
+			days++;
+	}
+	else
+	{
+		days = (days > 0)? days : 1;
+		end = localMidnight(start, days);
+	}
+
+	if(tracePath == 0)
+	{
+		syntheticTrace(start, end);
+		qsort(gEvents, gEventCount, sizeof(Event), compareEvents);
+	}
+	if((writePath != 0) && !writeTrace(writePath))
+	{
+		fprintf(stderr, "could not write %s\n", writePath);
+		return(1);
+	}
+
+	// the face starts at midnight on the first day, as the fake services leave it: full and connected
+	struct tm last;
+	localtime_r(&start, &last);
+	hostSetTime(&last);
+	hostSetBattery((BatteryChargeState){.charge_percent = 100});
+	hostSetConnection(true);
+	pebbleMain();
+	account(kCauseAppear, 1);
+	flush();
+
+	// and sweeps out to the time, a frame every animation timer period
+	bool sweeping;
+	do
+	{
+		sweeping = hostStepAnimations(33);
+		account(kCauseSweep, 1);
+		flush();
+	}
+	while(sweeping);
+
+	printf("%-10s %8s %8s %12s %10s %8s %12s\n", "day", "wakes", "frames", "pixels", "draws", "texts", "energy (mJ)");
+	Totals total = {0};
+	size_t next = 0;
+	time_t secondsUntil = 0;	// ticks come every second until then
+	while((next < gEventCount) && (gEvents[next].time < start))
+		next++;
+	for(time_t t = start; t < end; )
+	{
+		// the tick and the events of a second are one burst, and one frame
+		while((next < gEventCount) && (gEvents[next].time <= t))
+		{
+			deliver(&gEvents[next++]);
+			secondsUntil = t + 60;
+		}
+		flush();
+
+		// on to the next tick, or event before it
+		time_t step = (t < secondsUntil)? (t + 1) : (t - t % 60 + 60);
+		if((next < gEventCount) && (gEvents[next].time < step))
+			step = gEvents[next].time;
+		t = step;
+
+		// a day's report once its last tick's been delivered and drawn
+		struct tm local;
+		localtime_r(&t, &local);
+		if((t >= end) || (local.tm_mday != last.tm_mday))
+		{
+			printf(	"%04d-%02d-%02d %8u %8u %12llu %10llu %8llu %12.1f\n", last.tm_year + 1900, last.tm_mon + 1, last.tm_mday,
+					gDay.wakes, gDay.frames, (unsigned long long)gDay.pixelsWritten, (unsigned long long)gDay.drawCalls,
+					(unsigned long long)gDay.textLayouts, gDay.microjoules / 1000
+				);
+			addTotals(&total, &gDay);
+			gDay = (Totals){0};
+		}
+		if(t < end)
+			setClock(t, &last);
+	}
+
+	printf("\n%d simulated days, %zu events; per day, by cause:\n", days, gEventCount);
+	printf(	"  %-12s %8s %8s %12s %10s %8s %10s %6s %10s\n",
+			"cause", "wakes", "frames", "pixels", "draws", "texts", "trig", "vibes", "energy (mJ)"
+		);
+	for(int c = 0; c < kCauseCount; c++)
+	{
+		if(gCauses[c].wakes + gCauses[c].frames > 0)
+			printTotals(kCauseNames[c], &gCauses[c], days);
+	}
+	printTotals("total", &total, days);
+	printf("energy: %.1f mJ per simulated day\n", total.microjoules / 1000 / days);
+	return(0);
+}
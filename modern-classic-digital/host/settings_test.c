@@ -0,0 +1,207 @@
+// Persistent settings: every field round-trips through the packed record, unchanged settings
+// aren't rewritten and records written by earlier versions (the legacy one, versions 1 and 2)
+// migrate forward, and a quiet hours interval that doesn't divide the hour is taken down to one
+// that does.  The persisted battery history only records new levels and estimates the time
+// remaining from them.
+//
+// The watchface source is included directly so its static functions are reachable.
+
+#include "host.h"
+
+#define main pebbleMain
+#include "../modern-classic-digital.c"
+#undef main
+
+#include <stddef.h>
+
+static int gFailures = 0;
+
+#define EXPECT(condition) \
+	do { if(!(condition)) { fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); gFailures++; } } while(0)
+
+// a settings state in which every persisted field has a distinct value
+static void distinctSettings(void)
+{
+	memset(&gTimeState, 0, sizeof(gTimeState));
+
+	GColor* const colors[] =
+	{
+		&gTimeState.elapsedOuterColor, &gTimeState.elapsedOuterBackground,
+		&gTimeState.elapsedInnerColor, &gTimeState.elapsedInnerBackground,
+		&gTimeState.hourHandColor, &gTimeState.minuteHandColor,
+		&gTimeState.innermostBackgroundColor, &gTimeState.innermostTextColor,
+		&gTimeState.complicationMonthColor, &gTimeState.complicationDateColor,
+		&gTimeState.complicationDayColor, &gTimeState.complicationBatteryColor,
+		&gTimeState.complicationBatteryErrorColor, &gTimeState.backgroundColor,
+		&gTimeState.outerBackgroundColor,
+	};
+	for(unsigned int i = 0; i < sizeof(colors) / sizeof(colors[0]); i++)
+		colors[i]->argb = 0xC0 + i;
+
+	gTimeState.outerCircleOuterInset = 11;
+	gTimeState.outerCircleInnerInset = 9;
+	gTimeState.innerCircleOuterInset = 51;
+	gTimeState.innerCircleInnerInset = 6;
+	gTimeState.hourHandInset = 36;
+	gTimeState.hourHandWidth = 8;
+	gTimeState.minuteHandWidth = 4;
+	gTimeState.timeStyle = kOption12HourTime | kOptionHideMonth | kOptionVibrateOnDisconnect;
+	gTimeState.timeStyle2 = kLanguageRussian;
+	gTimeState.quietHours = 23 | (7 << 8) | (15 << 16);
+	gTimeState.complications = kSourceSteps | (kSourceDate << 4) | (kSourceSecondZone << 8) | ((uint32_t)(uint8_t)-20 << 16);
+}
+
+static void testRoundTrip(void)
+{
+	distinctSettings();
+	struct TimeState expected = gTimeState;
+	saveSettings();
+
+	memset(&gTimeState, 0, sizeof(gTimeState));
+	loadSettings();
+	EXPECT(memcmp(&gTimeState, &expected, sizeof(expected)) == 0);
+	EXPECT(sizeof(SavedSettings) == 37);
+}
+
+static void testUnchangedSettingsAreNotRewritten(void)
+{
+	distinctSettings();
+	saveSettings();
+
+	uint32_t writes = hostPersistWriteCount();
+	saveSettings();
+	EXPECT(hostPersistWriteCount() == writes);
+
+	gTimeState.hourHandWidth++;
+	saveSettings();
+	EXPECT(hostPersistWriteCount() == writes + 1);
+}
+
+static void testLegacyMigration(void)
+{
+	// what earlier versions wrote: the tail of TimeState from elapsedOuterColor on
+	distinctSettings();
+	gTimeState.quietHours = 0;	// not in the legacy record
+	gTimeState.complications = kSlotsDefault;
+	struct TimeState expected = gTimeState;
+	uint8_t legacy[kLegacySettingsSize] = {0};
+	size_t tail = sizeof(gTimeState) - offsetof(struct TimeState, elapsedOuterColor);
+	memcpy(legacy, &gTimeState.elapsedOuterColor, (tail < sizeof(legacy))? tail : sizeof(legacy));
+
+	persist_delete(kPersistKeySettings);
+	memset(&gSavedSettings, 0, sizeof(gSavedSettings));
+	persist_write_data(kPersistKeyLegacySettings, legacy, sizeof(legacy));
+
+	memset(&gTimeState, 0, sizeof(gTimeState));
+	loadSettings();
+	EXPECT(memcmp(&gTimeState, &expected, sizeof(expected)) == 0);
+	EXPECT(!persist_exists(kPersistKeyLegacySettings));
+	EXPECT(persist_exists(kPersistKeySettings));
+
+	// and the migrated record loads on its own
+	memset(&gTimeState, 0, sizeof(gTimeState));
+	loadSettings();
+	EXPECT(memcmp(&gTimeState, &expected, sizeof(expected)) == 0);
+}
+
+static void testEarlierVersionMigration(void)
+{
+	// earlier records are the current ones cut short: version 1 before quietHours, version 2
+	// before complications
+	for(uint8_t version = 1; version < kSettingsVersion; version++)
+	{
+		distinctSettings();
+		gTimeState.complications = kSlotsDefault;
+		if(version < 2)
+			gTimeState.quietHours = 0;
+		struct TimeState expected = gTimeState;
+		SavedSettings saved;
+		packSettings(&saved);
+		saved.version = version;
+		persist_write_data(kPersistKeySettings, &saved, kSettingsSizes[version]);
+
+		memset(&gTimeState, 0, sizeof(gTimeState));
+		loadSettings();
+		EXPECT(memcmp(&gTimeState, &expected, sizeof(expected)) == 0);
+
+		uint32_t writes = hostPersistWriteCount();
+		saveSettings();
+		EXPECT(hostPersistWriteCount() == writes + 1);
+		EXPECT(gSavedSettings.version == kSettingsVersion);
+	}
+}
+
+static void testUnknownVersionFallsBackToDefaults(void)
+{
+	distinctSettings();
+	SavedSettings saved;
+	packSettings(&saved);
+	saved.version = kSettingsVersion + 1;
+	persist_write_data(kPersistKeySettings, &saved, sizeof(saved));
+
+	loadSettings();
+	EXPECT(gTimeState.hourHandWidth == 7);
+	EXPECT(gTimeState.timeStyle == 0);
+}
+
+static void testQuietHoursInterval(void)
+{
+	// an interval that doesn't divide the hour would skip its first minute's redraw
+	uint32_t const intervals[][2] = {{0, 0}, {5, 5}, {7, 6}, {45, 30}, {60, 60}, {200, 60}};
+	for(unsigned int i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++)
+	{
+		applyConfigValue(KEY_QUIET_HOURS, 23 | (7 << 8) | (intervals[i][0] << 16));
+		EXPECT(gTimeState.quietHours == (23 | (7 << 8) | (intervals[i][1] << 16)));
+	}
+}
+
+static void testBatteryHistory(void)
+{
+	persist_delete(kPersistKeyBatteryHistory);
+	loadBatteryHistory();
+	EXPECT(batteryHoursRemaining() == -1);
+
+	// 10% in 10 hours, then 10% in 20: 3600 seconds per percent, then a quarter of the way to 7200
+	time_t const start = 1457049600;
+	recordBatterySample((BatteryChargeState){.charge_percent = 80}, start);
+	recordBatterySample((BatteryChargeState){.charge_percent = 70}, start + 10 * 3600);
+	EXPECT(gBatteryHistory.secondsPerPercent == 3600);
+
+	uint32_t writes = hostPersistWriteCount();
+	recordBatterySample((BatteryChargeState){.charge_percent = 70}, start + 11 * 3600);
+	EXPECT(hostPersistWriteCount() == writes);
+
+	recordBatterySample((BatteryChargeState){.charge_percent = 60}, start + 30 * 3600);
+	EXPECT(gBatteryHistory.secondsPerPercent == 4500);
+	EXPECT(gBatteryHistory.count == 3);
+
+	// the complication shows it, and the estimate survives a restart
+	memset(&gBatteryHistory, 0, sizeof(gBatteryHistory));
+	loadBatteryHistory();
+	gTimeState.timeStyle = kOptionBatteryTimeRemaining;
+	gTimeState.chargeLevel = 60;
+	gTimeState.chargeState = 0;
+	gTimeState.connectionLost = 0;
+	char string[kSlotTextSize];
+	int alert = 0;
+	EXPECT(formatBattery(string, sizeof(string), &alert) && (strcmp(string, " 75h") == 0));
+
+	// charging starts over, and without an estimate the complication falls back to the percentage
+	recordBatterySample((BatteryChargeState){.charge_percent = 60, .is_plugged = true}, start + 31 * 3600);
+	EXPECT((gBatteryHistory.count == 0) && (batteryHoursRemaining() == -1));
+	EXPECT(formatBattery(string, sizeof(string), &alert) && (strcmp(string, " 60%") == 0));
+}
+
+int main(void)
+{
+	testRoundTrip();
+	testUnchangedSettingsAreNotRewritten();
+	testLegacyMigration();
+	testEarlierVersionMigration();
+	testUnknownVersionFallsBackToDefaults();
+	testQuietHoursInterval();
+	testBatteryHistory();
+
+	printf("settings_test: %s\n", (gFailures == 0)? "passed" : "FAILED");
+	return((gFailures == 0)? 0 : 1);
+}
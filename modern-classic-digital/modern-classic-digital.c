@@ -1,10 +1,38 @@
 #include <pebble.h>
 #include <time.h>
 
+#include "face-geometry.h"
+#include "face-names.h"
+
+// Per-platform geometry, fixed at compile time.  The dial is the largest circle the display
+// holds, centered on it: the whole of chalk's round screen, and a square in the middle of
+// basalt's, diorite's, aplite's and emery's rectangular ones, with the strips beside it painted
+// the outer background color.  The default insets, hand widths and complication boxes are
+// chalk's (180 pixels across, in face-geometry.h), scaled to the dial.
+#if PBL_DISPLAY_WIDTH < PBL_DISPLAY_HEIGHT
+#define kDialDiameter		PBL_DISPLAY_WIDTH
+#else
+#define kDialDiameter		PBL_DISPLAY_HEIGHT
+#endif
+#define kDialScale(length)	((((length) * kDialDiameter) + 90) / 180)
+#define kDialBounds			GRect(	(PBL_DISPLAY_WIDTH - kDialDiameter) / 2, (PBL_DISPLAY_HEIGHT - kDialDiameter) / 2, \
+									kDialDiameter, kDialDiameter)
+
+// smaller dials take smaller type, so the complications fit between the rings
+#if kDialDiameter < 180
+#define kComplicationFont	FONT_KEY_GOTHIC_14
+#define kSlotSmallFont		FONT_KEY_GOTHIC_09
+#define kDateFont			FONT_KEY_GOTHIC_18
+#define kTimeFont			FONT_KEY_LECO_20_BOLD_NUMBERS
+#else
+#define kComplicationFont	FONT_KEY_GOTHIC_18
+#define kSlotSmallFont		FONT_KEY_GOTHIC_14	// for slot text too wide for kComplicationFont
+#define kDateFont			FONT_KEY_GOTHIC_24
+#define kTimeFont			FONT_KEY_LECO_28_LIGHT_NUMBERS
+#endif
+
 static Window* gWindow = 0;
-static Layer* gComplicationLayer = 0;
-static Layer* gDialLayer = 0;
-static Layer* gInnerLayer = 0;
+static Layer* gFaceLayer = 0;
 
 static struct TimeState
 {
@@ -43,9 +71,482 @@ static struct TimeState
 	GColor		backgroundColor,
 				outerBackgroundColor;
 
+	uint32_t	quietHours,		// see gQuietHours
+				complications;	// see gSlots
+
 } gTimeState = {0};
 
-#define kSaveSizeHack ((((15 * sizeof(GColor)) + 3) & ~3) + 9 * sizeof(uint32_t) + 4)
+// Incremental redraw.  The window background is clear, so the framebuffer keeps the previous
+// frame and a minute tick only needs to repaint the ring wedges that changed and the areas the
+// hands moved out of.  Any render that wasn't requested as a delta repaints everything.
+enum
+{
+	kRedrawNone = 0,
+	kRedrawDelta = 1,
+	kRedrawFull = 2,
+};
+
+// parts of the face a delta redraw repaints in full, on top of what the hands moved over
+enum
+{
+	kRedrawPartHands = (1 << 0),
+	kRedrawPartOuterRing = (1 << 1),
+	kRedrawPartInnerRing = (1 << 2),
+	kRedrawPartSlots = (1 << 3),		// the complication slots in gSlots.dirty
+	kRedrawPartSecondsSweep = (1 << 4),
+	kRedrawPartInnermost = (1 << 5),	// the innermost circle and the digital time
+	kRedrawPartBackgrounds = (1 << 6),	// the backgrounds' or cached slots' colors: recolor the cache and repaint
+	kRedrawPartEverything = (1 << 7),	// needs a full redraw
+};
+
+static struct RedrawState
+{
+	int			mode;
+	uint32_t	parts;			// kRedrawPart* for the next delta redraw
+	uint32_t	minuteAngle,	// dial angles (degrees) at the last render
+				hourAngle,
+				sweepAngle;		// end of the seconds sweep at the last render; 0 if none was drawn
+} gRedraw = {0};
+
+// Redraw scheduling.  The event handlers record what they changed in gRedraw and then ask for a
+// frame.  A tick shows the time, so redrawNow() marks the face dirty at once; the others call
+// scheduleRedraw(), which marks it dirty kRedrawWindowMs later, so a battery change and a
+// reconnect landing together, or just after a tick, render one frame between them, drawing
+// everything they asked for.  The sweep's frames keep to their own clock.
+#define kRedrawWindowMs 50
+
+static struct RedrawScheduler
+{
+	AppTimer*	timer;			// while the window is open
+	int			pending;		// whether a redraw waits on the window closing
+	uint32_t	requests,		// since launch
+				flushes,		// redraws they came to
+				merged;			// requests a scheduled redraw already covered
+} gRedrawScheduler = {0};
+
+// Seconds burst.  A tap switches the tick to seconds for a configurable number of them, shown as
+// a sweep along the outer edge of the minute ring in its inverted colors, then drops back to
+// minutes.  Each second only extends the sweep, so a burst costs at most one small redraw per
+// second it lasts.
+#define kSecondsBurstDefault 15
+#define kSecondsBurstMax 60
+#define kSecondsSweepThickness 3
+
+// The rings' insides are painted as spans, but the kRingEdgeWidth pixels along their edges are
+// left to graphics_fill_radial to antialias, and a ring too thin to have much inside is drawn by
+// it whole.
+#define kRingEdgeWidth 2
+#define kRingSpanThicknessMin (3 * kRingEdgeWidth)
+
+#define kMinuteTickUnits (YEAR_UNIT | MONTH_UNIT | DAY_UNIT | HOUR_UNIT | MINUTE_UNIT)
+
+static struct SecondsBurst
+{
+	uint32_t	remaining,		// second ticks left in the current burst; 0 when there's none
+				bursts,			// bursts started since launch
+				redraws;		// redraws caused by second ticks since launch
+} gSecondsBurst = {0};
+
+// Connection debouncing.  A flapping Bluetooth link would otherwise redraw the battery slot and
+// vibrate on every edge, so a drop only counts once the link has stayed down for the configured
+// delay (seconds, in timeStyle2's third byte; 0 takes it at once), and a vibration within
+// kConnectionVibrateCooldown seconds of the last one is skipped.
+#define kConnectionDelayDefault 10
+#define kConnectionDelayMax 60
+#define kConnectionVibrateCooldown (5 * 60)
+
+static struct Connection
+{
+	AppTimer*	pending;				// the delay a drop must outlast, while it runs
+	time_t		lastVibration;
+	uint32_t	flapsAbsorbed,			// drops that came back within the delay: two redraws each, saved
+				vibrationsSuppressed;	// disconnect vibrations skipped within the cooldown
+} gConnection = {0};
+
+// Quiet hours.  Overnight nobody looks at the face, so within the configured window the minute
+// tick only redraws every few minutes: the face shows the time of the last multiple of the
+// interval, as kOptionHourHandSnap does the hour hand.  quietHours holds the first hour of the
+// window in its low byte, the hour it ends in the next and the interval (minutes; 0 turns it off)
+// in the third.  A tap brings the face up to date and back to every minute for kQuietWakeMinutes.
+#define kQuietWakeMinutes 10
+
+static struct QuietHours
+{
+	uint32_t	wakeMinutes,	// minute ticks left before a tap's wake ends
+				ticksSkipped;	// minute ticks that didn't redraw since launch
+} gQuietHours = {0};
+
+// the quiet hours with their interval taken down to one that divides the hour, so the hour's
+// first minute is always one that redraws
+static uint32_t validQuietHours(uint32_t quietHours)
+{
+	uint32_t interval = ((quietHours >> 16) & 0xFF);
+	if(interval > 60)
+		interval = 60;
+	while((interval > 1) && ((60 % interval) != 0))
+		interval--;
+	return((quietHours & ~(0xFF << 16)) | (interval << 16));
+}
+
+// The sweep.  The first time the face opens, the rings and hands sweep out from 12 o'clock to the
+// time over kSweepFrames animation frames.  Every frame's angles are worked out before it starts,
+// so a frame is a lookup and the delta redraw a minute tick would do (the hands' ends come from
+// gLayout's tables as always).  A tap or a tick ends it at the time, a battery at or below
+// kSweepMinCharge skips it, and frames the animation skipped, or moved past before they were
+// drawn, are counted and logged as dropped.  aplite hasn't the memory to spare for it.
+#ifndef SWEEP_ON_APPEAR
+#if defined(PBL_PLATFORM_APLITE)
+#define SWEEP_ON_APPEAR 0
+#else
+#define SWEEP_ON_APPEAR 1
+#endif
+#endif
+
+#if SWEEP_ON_APPEAR
+#define kSweepFrames 16
+#define kSweepFrameMs 33
+#define kSweepMinCharge 20
+
+static struct Sweep
+{
+	Animation*	animation;					// while it runs
+	uint16_t	minuteAngles[kSweepFrames],
+				hourAngles[kSweepFrames];
+	uint8_t		frame,						// the frame being shown
+				drawn,						// and whether it has been
+				played;						// once per launch
+	uint32_t	framesDrawn,
+				framesDropped,
+				cancelled;					// sweeps cut short
+} gSweep = {0};
+#endif
+
+// Complication slots.  The four places between the rings (above the center, left of it, right of
+// it and below it) each show the data source they're bound to in gTimeState.complications: slot
+// s's kSource* in bits 4s to 4s + 3, and the second time zone's offset from UTC in quarter hours,
+// signed, in the third byte.  A source's value is formatted into its slots' text only on its own
+// events or every refreshMinutes minute ticks (see kComplicationSources), the renders draw that
+// text, and only a slot whose text or color changed is repainted.  The sources that change once a
+// day are drawn into the complication cache with the backgrounds, the others over it every time.
+enum
+{
+	kSlotTop = 0,
+	kSlotLeft = 1,
+	kSlotRight = 2,		// the tallest box, for the date in kDateFont
+	kSlotBottom = 3,
+	kSlotCount = 4,
+};
+
+enum
+{
+	kSourceNone = 0,
+	kSourceWeekday = 1,
+	kSourceMonth = 2,
+	kSourceDate = 3,
+	kSourceBattery = 4,		// or the lost connection
+	kSourceSteps = 5,		// from HealthService, where the platform has it
+	kSourceHeartRate = 6,
+	kSourceSecondZone = 7,
+	kSourceCount = 8,
+};
+
+#define kSourceBit(source)	(1 << (source))
+#define kSourcesAll			(kSourceBit(kSourceCount) - 1)
+#define kSourcesDaily		(kSourceBit(kSourceWeekday) | kSourceBit(kSourceMonth) | kSourceBit(kSourceDate))
+#define kSlotsDefault		(kSourceWeekday | (kSourceMonth << 4) | (kSourceDate << 8) | (kSourceBattery << 12))
+#define kSlotTextSize		16	// the longest month name, in Arabic, is 12 bytes of UTF-8
+
+// text too wide for its slot's box takes the smaller type, then two lines of it, then loses its end
+enum
+{
+	kSlotFitNormal = 0,
+	kSlotFitSmall = 1,
+	kSlotFitTwoLines = 2,
+};
+
+static struct ComplicationSlots
+{
+	struct ComplicationSlot
+	{
+		uint8_t		source,
+					shown;
+		GColor		color;
+		char		text[kSlotTextSize];
+		uint8_t		fit,			// kSlotFit*: how the text is laid out to fit the slot's box
+					lineBreak,		// with kSlotFitTwoLines, the text's index that starts the second line
+					length;			// the bytes of text shown
+	}			slots[kSlotCount];
+	uint8_t		dirty,						// bit s: slot s changed, for the next delta redraw to repaint
+				unmeasured,					// bit s: slot s's text is to be fitted to its box again
+				minutes[kSourceCount];		// minute ticks since each source was last formatted
+	uint32_t	formats,					// source values formatted since launch
+				repaints;					// slots repainted on their own since launch
+} gSlots = {0};
+
+// Cold-start snapshot.  The first render of each day, and the first after the settings change,
+// run-length encodes the finished frame into persistent storage.  On a cold start the first frame
+// decodes it straight into the framebuffer; the appear work (the time, the battery, the
+// connection, the slots) waits on a timer, and the live render replaces the snapshot once it's
+// done.  That's a frame or two later, so hands hours out of date don't matter, where saving every
+// minute would spend several times the drawing's energy on flash writes.
+// The frame's colors become a palette of at most kSnapshotColors.  Each row's visible span (all
+// of it, except on round displays) is stored as runs of one byte each: the color's index in the
+// high nibble and the run's length less one in the low.  A low nibble of 15 means 16 plus a
+// little-endian base-128 count in the bytes that follow.  The runs fill kSnapshotKeys persist
+// values at most, and a frame that needs more, or more colors, isn't saved.  Only the 8-bit
+// framebuffers have it, like the complication cache.
+// The render only encodes the frame, into the complication cache's bitmap, which there's no
+// memory to spare beside; the persist writes wait on a timer until it has returned, and the
+// cache is captured again on the next full redraw.
+#if defined(PBL_COLOR)
+#define kSnapshotVersion 1
+#define kSnapshotColors 16
+#define kSnapshotKeys 12	// of PERSIST_DATA_MAX_LENGTH bytes, well inside the app's 4 KB of persist
+
+static struct Snapshot
+{
+	uint8_t		pending,			// the first render draws the snapshot rather than the face
+				due,				// the next render saves its frame
+				fits;				// the one encoded for writer has few enough colors and runs
+	AppTimer*	writer;				// while an encoded one waits to be written
+	uint16_t	size,				// bytes of runs in the last one saved or drawn
+				encodeMs,
+				decodeMs;
+	uint32_t	saves,
+				writes,				// persist values written, unchanged ones being skipped
+				skipped;			// frames with too many colors or runs to save
+} gSnapshot = {0};
+#define snapshotWriting()	(gSnapshot.writer != 0)
+#else
+#define snapshotWriting()	0
+#endif
+
+// Render profiling.  Building with PROFILE_RENDERING=1 times every render stage and keeps the last
+// kProfileSamples frames in a ring buffer, along with what invalidated each; a tap dumps it all
+// through APP_LOG.  PROFILE_RENDERING_OVERLAY=1 also shows the last frame's times (ms) in the
+// inner circle, in place of the digital time.  When disabled none of it is compiled.
+#ifndef PROFILE_RENDERING
+#define PROFILE_RENDERING 0
+#endif
+#ifndef PROFILE_RENDERING_OVERLAY
+#define PROFILE_RENDERING_OVERLAY 0
+#endif
+
+#if PROFILE_RENDERING
+
+enum
+{
+	kProfileStageComplications = 0,	// in render order; the complications start a frame
+	kProfileStageDial = 1,
+	kProfileStageInner = 2,
+	kProfileStageCount = 3,
+};
+
+enum
+{
+	kProfileCauseTick = (1 << 0),
+	kProfileCauseSecondsTick = (1 << 1),
+	kProfileCauseBattery = (1 << 2),
+	kProfileCauseConnection = (1 << 3),
+	kProfileCauseConfig = (1 << 4),
+	kProfileCauseTap = (1 << 5),
+	kProfileCauseAppear = (1 << 6),
+	kProfileCauseSweep = (1 << 7),
+	kProfileCauseCount = 8,
+};
+
+static char const* const kProfileCauseNames[kProfileCauseCount] = {"tick", "second", "battery", "connection", "config", "tap", "appear", "sweep"};
+static char const* const kProfileStageNames[kProfileStageCount] = {"complication", "dial", "inner"};
+
+#define kProfileSamples 32
+
+static struct Profile
+{
+	uint8_t		pendingCauses;		// kProfileCause*s since the last frame
+	uint32_t	frames,				// frames begun; samples[frames % kProfileSamples] is the newest
+				causeCounts[kProfileCauseCount];
+
+	struct
+	{
+		uint32_t	renders,
+					totalMs;
+		uint16_t	minMs,
+					maxMs;
+	} stages[kProfileStageCount];
+
+	struct
+	{
+		uint8_t		causes,
+					mode;			// kRedraw*
+		uint16_t	ms[kProfileStageCount];
+	} samples[kProfileSamples];
+
+	time_t		startSeconds;		// of the stage running now
+	uint16_t	startMs;
+} gProfile = {0};
+
+#define PROFILE_CAUSE(cause)	(gProfile.pendingCauses |= (cause))
+
+static void profileBegin(int stage)
+{
+	if(stage == kProfileStageComplications)
+	{
+		gProfile.frames++;
+		uint32_t index = gProfile.frames % kProfileSamples;
+		memset(&gProfile.samples[index], 0, sizeof(gProfile.samples[index]));
+		gProfile.samples[index].causes = gProfile.pendingCauses;
+		gProfile.samples[index].mode = gRedraw.mode;
+
+		for(int c = 0; c < kProfileCauseCount; c++)
+			if(gProfile.pendingCauses & (1 << c))
+				gProfile.causeCounts[c]++;
+		gProfile.pendingCauses = 0;
+	}
+	time_ms(&gProfile.startSeconds, &gProfile.startMs);
+}
+
+static void profileEnd(int stage)
+{
+	time_t seconds;
+	uint16_t ms;
+	time_ms(&seconds, &ms);
+	uint32_t elapsed = (uint32_t)(seconds - gProfile.startSeconds) * 1000 + ms - gProfile.startMs;
+
+	if((gProfile.stages[stage].renders == 0) || (elapsed < gProfile.stages[stage].minMs))
+		gProfile.stages[stage].minMs = elapsed;
+	if(elapsed > gProfile.stages[stage].maxMs)
+		gProfile.stages[stage].maxMs = elapsed;
+	gProfile.stages[stage].renders++;
+	gProfile.stages[stage].totalMs += elapsed;
+	gProfile.samples[gProfile.frames % kProfileSamples].ms[stage] = elapsed;
+}
+
+static void profileDump(void)
+{
+	APP_LOG(APP_LOG_LEVEL_INFO, "profile: %u frames", (unsigned int)gProfile.frames);
+	for(int l = 0; l < kProfileStageCount; l++)
+	{
+		uint32_t renders = gProfile.stages[l].renders;
+		APP_LOG(	APP_LOG_LEVEL_INFO, "  %s: %u renders, min %u avg %u max %u ms", kProfileStageNames[l],
+					(unsigned int)renders, gProfile.stages[l].minMs,
+					(unsigned int)((renders > 0)? (gProfile.stages[l].totalMs / renders) : 0), gProfile.stages[l].maxMs
+				);
+	}
+	for(int c = 0; c < kProfileCauseCount; c++)
+		APP_LOG(APP_LOG_LEVEL_INFO, "  %s: %u frames", kProfileCauseNames[c], (unsigned int)gProfile.causeCounts[c]);
+	APP_LOG(	APP_LOG_LEVEL_INFO, "  connection: %u flaps absorbed, %u vibrations suppressed",
+				(unsigned int)gConnection.flapsAbsorbed, (unsigned int)gConnection.vibrationsSuppressed
+			);
+	APP_LOG(APP_LOG_LEVEL_INFO, "  quiet hours: %u minute ticks skipped", (unsigned int)gQuietHours.ticksSkipped);
+	APP_LOG(	APP_LOG_LEVEL_INFO, "  scheduler: %u redraws asked for, %u done, %u merged into one already scheduled",
+				(unsigned int)gRedrawScheduler.requests, (unsigned int)gRedrawScheduler.flushes, (unsigned int)gRedrawScheduler.merged
+			);
+#if SWEEP_ON_APPEAR
+	APP_LOG(	APP_LOG_LEVEL_INFO, "  sweep: %u frames drawn, %u dropped, %u cut short", (unsigned int)gSweep.framesDrawn,
+				(unsigned int)gSweep.framesDropped, (unsigned int)gSweep.cancelled
+			);
+#endif
+	APP_LOG(	APP_LOG_LEVEL_INFO, "  slots: %u values formatted, %u slots repainted on their own",
+				(unsigned int)gSlots.formats, (unsigned int)gSlots.repaints
+			);
+#if defined(PBL_COLOR)
+	APP_LOG(	APP_LOG_LEVEL_INFO, "  snapshot: %u bytes of %u, %u saved (%u values written), %u skipped, encode %u ms, decode %u ms",
+				gSnapshot.size, kSnapshotKeys * PERSIST_DATA_MAX_LENGTH, (unsigned int)gSnapshot.saves,
+				(unsigned int)gSnapshot.writes, (unsigned int)gSnapshot.skipped, gSnapshot.encodeMs, gSnapshot.decodeMs
+			);
+#endif
+
+	// oldest first
+	uint32_t count = (gProfile.frames < kProfileSamples)? gProfile.frames : kProfileSamples;
+	for(uint32_t f = gProfile.frames + 1 - count; f <= gProfile.frames; f++)
+	{
+		uint32_t index = f % kProfileSamples;
+		APP_LOG(	APP_LOG_LEVEL_INFO, "  frame %u: causes 0x%02x mode %u, %u/%u/%u ms", (unsigned int)f,
+					gProfile.samples[index].causes, gProfile.samples[index].mode,
+					gProfile.samples[index].ms[0], gProfile.samples[index].ms[1], gProfile.samples[index].ms[2]
+				);
+	}
+}
+
+#else
+
+#define PROFILE_CAUSE(cause)
+
+#endif
+
+// The backgrounds and the slots showing the date change at most once a day, so after they're
+// drawn they're copied from the framebuffer into this bitmap and copied back on later redraws.
+// Only the other slots are drawn every time.  Face layer coordinates are
+// framebuffer coordinates, since the layer covers the whole window.
+static GBitmap* gComplicationCache = 0;
+static int gComplicationCacheValid = 0;
+
+// Geometry derived from the dial bounds and the insets and hand widths in gTimeState, which
+// only change with the settings: rebuilt by updateLayout() in onWindowLoad and after a
+// configuration message, so the render procs only look it up.  The hand tables are indexed by
+// minute and by hour-hand angle (whole degrees, see currentDialAngles).
+static struct Layout
+{
+	GRect		screen,				// the window
+				bounds;				// the dial, kDialBounds
+	GPoint		center;
+	GRect		outerCircle,		// outer edge of the minute ring
+				innerCircle,		// outer edge of the hour ring
+				hourCircle,			// where the hour hand ends
+				hourInnerCircle,	// inner edge of the hour ring, where the hands start
+				timeBox,			// the digital time
+				slotBoxes[kSlotCount];
+	int16_t		slotSectors[kSlotCount][2];	// [start, end) degrees around the center covering each box
+	int32_t		minuteHandMargin,	// handSweepMargin() of each hand
+				hourHandMargin,
+				innermostEdge;		// how far the hands' round caps reach into the innermost circle
+	GPoint		minuteHand[60][2],	// inner and outer ends
+				hourHand[360][2];
+	struct RingSpans
+	{
+		GRect		circle;
+		uint32_t	thickness;
+		uint8_t		outer[kDialDiameter / 2],	// on the rows k above and below the center, how many pixels
+					inner[kDialDiameter / 2];	// either side of the center column lie within each edge
+	}			ringSpans[3];		// the minute ring, the hour ring and the seconds sweep
+	GRect		timeCells[4];		// the digital time's hour and minute digits, a 2x2 grid
+	int16_t		timeCellSectors[4][2];	// as daySector etc., covering each cell's ink
+	uint8_t		timeCellsAtEdge;	// bit i: cell i's ink reaches within innermostEdge of the edge
+} gLayout;
+
+// Pre-rendered digits for the digital time.  Each of 0-9 and space is rasterized once through
+// the text engine into a bit mask of its cell, and the time's four cells are then drawn from
+// the masks straight into the framebuffer, each only when its digit changes or the hands' caps
+// were painted over it; the dial stage no longer clears the innermost circle every frame.  The
+// masks are color-free, so recoloring needs no re-rasterizing.  The 1-bit displays keep the text
+// engine, as does the profiling overlay, which draws over the time.  TIME_GLYPH_ATLAS=0 builds
+// without it, for comparison.
+#ifndef TIME_GLYPH_ATLAS
+#if defined(PBL_COLOR) && !(PROFILE_RENDERING && PROFILE_RENDERING_OVERLAY)
+#define TIME_GLYPH_ATLAS 1
+#else
+#define TIME_GLYPH_ATLAS 0
+#endif
+#endif
+
+enum
+{
+	kTimeGlyphSpace = 10,
+	kTimeGlyphCount = 11,
+	kTimeGlyphNone = 0xFF,
+	kTimeGlyphMaxWidth = 32,	// bits in a mask row
+	kTimeGlyphMaxHeight = 40,
+};
+
+static struct TimeGlyphs
+{
+	int			built;
+	GRect		ink;			// the union of the glyphs' ink, relative to a cell
+	// bit x of row y: ink at (x, y); without the atlas they're never built, so there's no room kept
+	uint32_t	masks[TIME_GLYPH_ATLAS? kTimeGlyphCount : 1][kTimeGlyphMaxHeight];
+	uint8_t		drawn[4],		// the glyph each cell shows, kTimeGlyphNone if it's clear
+				stale;			// bit i: cell i was partly painted over, and is redrawn even if unchanged
+} gTimeGlyphs;
 
 enum
 {
@@ -61,6 +562,7 @@ enum
 	kOptionHideConnectionLost = (1 << 9),
 	kOptionHideDigitalTime = (1 << 10),
 	kOptionVibrateOnDisconnect = (1 << 11),
+	kOptionBatteryTimeRemaining = (1 << 12),
 };
 
 enum
@@ -102,338 +604,2437 @@ enum
 	KEY_FLAGS2 = 14,
 	KEY_BACKGROUND_COLOR = 15,
 	KEY_OUTER_BACKGROUND_COLOR = 16,
+
+	KEY_CONFIG = 17,
+	KEY_QUIET_HOURS = 18,
+	KEY_COMPLICATIONS = 19,
 };
 
+// Configuration arrives as one byte-array tuple under KEY_CONFIG: a version byte, then for each
+// setting that changed since the phone's last acknowledged message its KEY_* and its value,
+// little-endian.  KEY_FLAGS, KEY_FLAGS2, KEY_QUIET_HOURS and KEY_COMPLICATIONS take four bytes;
+// colors take one, as GColor8 ARGB.  KEY_CONFIG itself is never one of them.
+#define kConfigVersion 1
+#define kConfigKeyCount (KEY_COMPLICATIONS + 1)
+#define kConfigValueSize(key) (	(	((key) == KEY_FLAGS) || ((key) == KEY_FLAGS2) || ((key) == KEY_QUIET_HOURS) \
+									||	((key) == KEY_COMPLICATIONS)	)? 4 : 1	)
+#define kConfigMaxSize (1 + (2 * kConfigKeyCount) + (3 * 4))
 
-static char const* const kDaysOfWeek[] =
+enum
 {
-	"د", "ن", "ث", "ع", "خ", "ج", "س",					// kLanguageArabic = 1
-	"SO.", "MO.", "DI.", "MI.", "DO.", "FR.", "SA.",	// kLanguageGerman = 2
-	"SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT",	// kLanguageEnglish = 3
-	"DOM", "LUN", "MAR", "MIE", "JUE", "VIE", "SAB",	// kLanguageSpanish = 4
-	"DIM", "LUN", "MAR", "MER", "JEU", "VEN", "SAM",	// kLanguageFrench = 5
-	"DOM", "LUN", "MAR", "MER", "GIO", "VEN", "SAB",	// kLanguageItalian = 6
-	"ZON", "MAA", "DIN", "WOE", "DON", "VRI", "ZAT", 	// kLanguageDutch = 7
-	"DOM", "SEG", "TER", "QUA", "QUI", "SEX", "SÁB",	// kLanguagePortuguese = 8
-	"ПНД", "ВТР", "СРД", "ЧТВ", "ПТН", "СБТ", "ВСК",	// kLanguageRussian = 9
-	//"VSK", "PND", "VTR", "SRD", "CHT", "PTN", "SBT",	// kLanguageRussian = 9 (Romanized)
+	kPersistKeyLegacySettings = 0,	// raw TimeState dump written by earlier versions
+	kPersistKeySettings = 1,
+	kPersistKeyBatteryHistory = 2,
+	kPersistKeySnapshot = 3,		// the snapshot's header; its runs follow from kPersistKeySnapshotData
+	kPersistKeySnapshotData = 4,
 };
 
-static char const* const kMonthNames[] =
-{
-	"ٌناٌر", "فبراٌر", "مارس", "إبرٌل", "ماٌو", "ٌونٌو", "ٌولٌو", "أؼسطس", "سبتمبر", "أكتوبر", "نوفمبر", "دٌسمبر",		// kLanguageArabic = 1	// TODO: Hijri calendar
-	"JÄN", "FEB", "MÄR", "APR", "MAI", "JUN", "JUL", "AUG", "SEP", "OKT", "NOV", "DEZ", 	// kLanguageGerman = 2
-	"JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC",		// kLanguageEnglish = 3
-	"ENE", "FEB", "MAR", "ABR", "MAY", "JUN", "JUL", "AGO", "SEP", "OCT", "NOV", "DIC",		// kLanguageSpanish = 4
-	"JAN", "FÉV", "MAR", "AVR", "MAI", "JUN", "JUL", "AOÛ", "SEP", "OCT", "NOV", "DÉC", 	// kLanguageFrench = 5
-	"GEN", "FEB", "MAR", "APR", "MAG", "GIU", "LUG", "AGO", "SET", "OTT", "NOV", "DIC", 	// kLanguageItalian = 6
-	"JAN", "FEB", "MAR", "APR", "MEI", "JUN", "JUL", "AUG", "SEP", "OKT", "NOV", "DEC",		// kLanguageDutch = 7
-	"JAN", "FEV", "MAR", "ABR", "MAI", "JUN", "JUL", "AGO", "SET", "OUT", "NOV", "DEZ",		// kLanguagePortuguese = 8
-	"янв", "фев", "мар", "апр", "май", "июн", "июл", "авг", "сен", "окт", "ноя", "дек",		// kLanguageRussian = 9
-	//"IAN", "FEV", "MAR", "APR", "MAI", "IUN", "IUL", "AVG", "SEN", "OKT", "NOI", "DEK",	// kLanguageRussian = 9 (Romanized)
+// Persisted settings.  The record is packed and byte-sized where the values allow, so its layout
+// doesn't depend on struct TimeState or on padding; bump kSettingsVersion whenever it changes and
+// teach loadSettings() to read the old version.
+#define kSettingsVersion 3
+
+typedef struct __attribute__((__packed__)) SavedSettings
+{
+	uint8_t		version;
+
+	uint8_t		elapsedOuterColor,		// GColor8 ARGB
+				elapsedOuterBackground,
+				elapsedInnerColor,
+				elapsedInnerBackground,
+				hourHandColor,
+				minuteHandColor,
+				innermostBackgroundColor,
+				innermostTextColor,
+				complicationMonthColor,
+				complicationDateColor,
+				complicationDayColor,
+				complicationBatteryColor,
+				complicationBatteryErrorColor,
+				backgroundColor,
+				outerBackgroundColor;
+
+	uint8_t		outerCircleOuterInset,
+				outerCircleInnerInset,
+				innerCircleOuterInset,
+				innerCircleInnerInset,
+				hourHandInset,
+				hourHandWidth,
+				minuteHandWidth;
+
+	uint16_t	timeStyle;		// kOption* flags
+	uint32_t	timeStyle2;		// language in the low byte, seconds burst length (seconds) in the next,
+								// connection loss delay (seconds) in the third
+
+	uint32_t	quietHours;		// from version 2
+	uint32_t	complications;	// from version 3
+} SavedSettings;
+
+// the size of each version's record: each ends before the fields later versions added
+static uint8_t const kSettingsSizes[kSettingsVersion + 1] =
+{
+	0, offsetof(SavedSettings, quietHours), offsetof(SavedSettings, complications), sizeof(SavedSettings),
 };
 
-int automaticLanguage(void)
+// the last record read or written, so unchanged settings are never rewritten to flash
+static SavedSettings gSavedSettings = {0};
+
+// Layout of the legacy record: TimeState from elapsedOuterColor on (kSaveSizeHack bytes), i.e.
+// 13 colors, 2 bytes of padding, 9 little-endian words, then the last 2 colors.
+#define kLegacySettingsSize 56
+#define kLegacySettingsWordsOffset 15		// byte offsets into the record
+#define kLegacySettingsLastColorsOffset 51
+
+static void defaultSettings(void)
 {
-	char const* iso = i18n_get_system_locale();
-	
-	switch(iso[0])
-	{
-	case 'a':
-		if(iso[1] == 'r')	return(kLanguageArabic);
-		break;
-	case 'd':
-		if(iso[1] == 'e')	return(kLanguageGerman);
-		break;
-	case 'e':
-		if(iso[1] == 'n')	return(kLanguageEnglish);
-		if(iso[1] == 's')	return(kLanguageSpanish);
-		break;
-	case 'f':
-		if(iso[1] == 'r')	return(kLanguageFrench);
-		break;
-	case 'i':
-		if(iso[1] == 't')	return(kLanguageItalian);
-		break;
-	case 'n':
-		if(iso[1] == 'l')	return(kLanguageDutch);
-		break;
-	case 'p':
-		if(iso[1] == 't')	return(kLanguagePortuguese);
-		break;
-	case 'r':
-		if(iso[1] == 'u')	return(kLanguageRussian);
-		break;
-	}
+	gTimeState.elapsedOuterColor = GColorDarkCandyAppleRed;
+	gTimeState.elapsedOuterBackground = GColorLightGray;
+	gTimeState.elapsedInnerColor = GColorBlue;
+	gTimeState.elapsedInnerBackground = GColorLightGray;
+	gTimeState.hourHandColor = GColorBlue;
+	gTimeState.minuteHandColor = GColorDarkCandyAppleRed;
+	gTimeState.innermostBackgroundColor = GColorWhite;
+	gTimeState.innermostTextColor = GColorBlack;
+	gTimeState.complicationMonthColor = GColorDarkGray;
+	gTimeState.complicationDateColor = GColorDarkGray;
+	gTimeState.complicationDayColor = GColorDarkGray;
+	gTimeState.complicationBatteryColor = GColorDarkGray;
+	gTimeState.complicationBatteryErrorColor = GColorDarkCandyAppleRed;
+	gTimeState.backgroundColor = GColorWhite;
+	gTimeState.outerBackgroundColor = GColorWhite;
+
+	gTimeState.outerCircleOuterInset = kDialScale(kDefaultOuterCircleOuterInset),
+	gTimeState.outerCircleInnerInset = kDialScale(kDefaultOuterCircleInnerInset),
+	gTimeState.innerCircleOuterInset = gTimeState.outerCircleOuterInset + kDialScale(kDefaultInnerCircleSpacing),
+	gTimeState.innerCircleInnerInset = kDialScale(kDefaultInnerCircleInnerInset),
+	gTimeState.hourHandInset = gTimeState.outerCircleOuterInset + kDialScale(kDefaultHourHandSpacing),
+	gTimeState.hourHandWidth = kDialScale(kDefaultHourHandWidth),
+	gTimeState.minuteHandWidth = kDialScale(kDefaultMinuteHandWidth);
+
+	gTimeState.timeStyle = 0;
+	gTimeState.timeStyle2 = (kSecondsBurstDefault << 8) | (kConnectionDelayDefault << 16);
+	gTimeState.quietHours = 0;
+	gTimeState.complications = kSlotsDefault;
+}
 
-	return(kLanguageEnglish);	// fallback
+static void packSettings(SavedSettings* saved)
+{
+	saved->version = kSettingsVersion;
+
+	saved->elapsedOuterColor = gTimeState.elapsedOuterColor.argb;
+	saved->elapsedOuterBackground = gTimeState.elapsedOuterBackground.argb;
+	saved->elapsedInnerColor = gTimeState.elapsedInnerColor.argb;
+	saved->elapsedInnerBackground = gTimeState.elapsedInnerBackground.argb;
+	saved->hourHandColor = gTimeState.hourHandColor.argb;
+	saved->minuteHandColor = gTimeState.minuteHandColor.argb;
+	saved->innermostBackgroundColor = gTimeState.innermostBackgroundColor.argb;
+	saved->innermostTextColor = gTimeState.innermostTextColor.argb;
+	saved->complicationMonthColor = gTimeState.complicationMonthColor.argb;
+	saved->complicationDateColor = gTimeState.complicationDateColor.argb;
+	saved->complicationDayColor = gTimeState.complicationDayColor.argb;
+	saved->complicationBatteryColor = gTimeState.complicationBatteryColor.argb;
+	saved->complicationBatteryErrorColor = gTimeState.complicationBatteryErrorColor.argb;
+	saved->backgroundColor = gTimeState.backgroundColor.argb;
+	saved->outerBackgroundColor = gTimeState.outerBackgroundColor.argb;
+
+	saved->outerCircleOuterInset = gTimeState.outerCircleOuterInset;
+	saved->outerCircleInnerInset = gTimeState.outerCircleInnerInset;
+	saved->innerCircleOuterInset = gTimeState.innerCircleOuterInset;
+	saved->innerCircleInnerInset = gTimeState.innerCircleInnerInset;
+	saved->hourHandInset = gTimeState.hourHandInset;
+	saved->hourHandWidth = gTimeState.hourHandWidth;
+	saved->minuteHandWidth = gTimeState.minuteHandWidth;
+
+	saved->timeStyle = gTimeState.timeStyle;
+	saved->timeStyle2 = gTimeState.timeStyle2;
+	saved->quietHours = gTimeState.quietHours;
+	saved->complications = gTimeState.complications;
 }
 
-// dayIndexZeroBased treats 0 as Sunday
-static char const* localizedDayOfWeek(int dayIndexZeroBased)
+static void unpackSettings(SavedSettings const* saved)
 {
-	int lang = (gTimeState.timeStyle2 & 0xFF);
-	if(lang == kLanguageAutomatic)
-		lang = automaticLanguage();
+	gTimeState.elapsedOuterColor.argb = saved->elapsedOuterColor;
+	gTimeState.elapsedOuterBackground.argb = saved->elapsedOuterBackground;
+	gTimeState.elapsedInnerColor.argb = saved->elapsedInnerColor;
+	gTimeState.elapsedInnerBackground.argb = saved->elapsedInnerBackground;
+	gTimeState.hourHandColor.argb = saved->hourHandColor;
+	gTimeState.minuteHandColor.argb = saved->minuteHandColor;
+	gTimeState.innermostBackgroundColor.argb = saved->innermostBackgroundColor;
+	gTimeState.innermostTextColor.argb = saved->innermostTextColor;
+	gTimeState.complicationMonthColor.argb = saved->complicationMonthColor;
+	gTimeState.complicationDateColor.argb = saved->complicationDateColor;
+	gTimeState.complicationDayColor.argb = saved->complicationDayColor;
+	gTimeState.complicationBatteryColor.argb = saved->complicationBatteryColor;
+	gTimeState.complicationBatteryErrorColor.argb = saved->complicationBatteryErrorColor;
+	gTimeState.backgroundColor.argb = saved->backgroundColor;
+	gTimeState.outerBackgroundColor.argb = saved->outerBackgroundColor;
+
+	gTimeState.outerCircleOuterInset = saved->outerCircleOuterInset;
+	gTimeState.outerCircleInnerInset = saved->outerCircleInnerInset;
+	gTimeState.innerCircleOuterInset = saved->innerCircleOuterInset;
+	gTimeState.innerCircleInnerInset = saved->innerCircleInnerInset;
+	gTimeState.hourHandInset = saved->hourHandInset;
+	gTimeState.hourHandWidth = saved->hourHandWidth;
+	gTimeState.minuteHandWidth = saved->minuteHandWidth;
+
+	gTimeState.timeStyle = saved->timeStyle;
+	gTimeState.timeStyle2 = saved->timeStyle2;
+	gTimeState.quietHours = validQuietHours(saved->quietHours);
+	gTimeState.complications = saved->complications;
+}
 
-	return(kDaysOfWeek[7 * (lang - 1) + dayIndexZeroBased]);
+static uint32_t legacyWord(uint8_t const* legacy, int index)
+{
+	uint8_t const* p = legacy + kLegacySettingsWordsOffset + 4 * index;
+	return(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
 }
 
-// monthIndexZeroBased treats 0 as January
-static char const* localizedMonthName(int monthIndexZeroBased)
+static void unpackLegacySettings(uint8_t const* legacy)
+{
+	GColor* const colors[] =
+	{
+		&gTimeState.elapsedOuterColor, &gTimeState.elapsedOuterBackground,
+		&gTimeState.elapsedInnerColor, &gTimeState.elapsedInnerBackground,
+		&gTimeState.hourHandColor, &gTimeState.minuteHandColor,
+		&gTimeState.innermostBackgroundColor, &gTimeState.innermostTextColor,
+		&gTimeState.complicationMonthColor, &gTimeState.complicationDateColor,
+		&gTimeState.complicationDayColor, &gTimeState.complicationBatteryColor,
+		&gTimeState.complicationBatteryErrorColor,
+	};
+	for(unsigned int i = 0; i < sizeof(colors) / sizeof(colors[0]); i++)
+		colors[i]->argb = legacy[i];
+
+	gTimeState.timeStyle = legacyWord(legacy, 0);
+	gTimeState.outerCircleOuterInset = legacyWord(legacy, 1);
+	gTimeState.outerCircleInnerInset = legacyWord(legacy, 2);
+	gTimeState.innerCircleOuterInset = legacyWord(legacy, 3);
+	gTimeState.innerCircleInnerInset = legacyWord(legacy, 4);
+	gTimeState.hourHandInset = legacyWord(legacy, 5);
+	gTimeState.hourHandWidth = legacyWord(legacy, 6);
+	gTimeState.minuteHandWidth = legacyWord(legacy, 7);
+	gTimeState.timeStyle2 = legacyWord(legacy, 8);
+
+	gTimeState.backgroundColor.argb = legacy[kLegacySettingsLastColorsOffset];
+	gTimeState.outerBackgroundColor.argb = legacy[kLegacySettingsLastColorsOffset + 1];
+}
+
+// writes the settings to flash, but only if they differ from what's already there
+static void saveSettings(void)
 {
-	int lang = gTimeState.timeStyle2 & 0xFF;
-	if(lang == kLanguageAutomatic)
-		lang = automaticLanguage();
-	return(kMonthNames[12 * (lang - 1) + monthIndexZeroBased]);
+	SavedSettings saved;
+	packSettings(&saved);
+	if(memcmp(&saved, &gSavedSettings, sizeof(saved)) == 0)
+		return;
+
+	if(persist_write_data(kPersistKeySettings, &saved, sizeof(saved)) == (int)sizeof(saved))
+		gSavedSettings = saved;
 }
 
-static void updateTime(struct tm const* currentTime)
+static void loadSettings(void)
 {
-	if(gTimeState.timeStyle & kOptionDemoMode)
+	SavedSettings saved;
+	uint8_t legacy[kLegacySettingsSize];
+
+	// an earlier version's record is read over the defaults, which fill the fields it lacks
+	defaultSettings();
+	packSettings(&saved);
+	int size = persist_exists(kPersistKeySettings)? persist_read_data(kPersistKeySettings, &saved, sizeof(saved)) : 0;
+
+	if((size > 0) && (saved.version >= 1) && (saved.version <= kSettingsVersion) && (size == kSettingsSizes[saved.version]))
 	{
-		gTimeState.hours = 1;
-		gTimeState.minutes = 50;
-		gTimeState.seconds = 0;
-		gTimeState.days = 4;
-		gTimeState.months = 3;
-		gTimeState.weekDay = 5;
+		// and is rewritten as the current one the next time settings are saved
+		unpackSettings(&saved);
+		gSavedSettings = saved;
 	}
-	else
+	else if(	persist_exists(kPersistKeyLegacySettings)
+			&&	(persist_read_data(kPersistKeyLegacySettings, legacy, sizeof(legacy)) == (int)sizeof(legacy))
+	)
 	{
-		gTimeState.hours = currentTime->tm_hour;
-		gTimeState.minutes = currentTime->tm_min;
-		gTimeState.seconds = currentTime->tm_sec;
-		gTimeState.days = currentTime->tm_mday;
-		gTimeState.months = currentTime->tm_mon;
-		gTimeState.weekDay = currentTime->tm_wday;
+		// migrate forward once, then drop the old record
+		unpackLegacySettings(legacy);
+		saveSettings();
+		persist_delete(kPersistKeyLegacySettings);
 	}
 }
 
-static void onTimeChanged(struct tm* currentTime, TimeUnits units)
+// Battery history.  The battery service reports the charge in coarse steps, so while the watch
+// runs on its battery each new level is recorded with the time it was reached, in a ring that's
+// persisted (a few writes a day) so a restart doesn't lose the trend.  The discharge rate is
+// averaged in as each step arrives; charging starts the history over.
+#define kBatterySamples 8
+#define kBatteryHistoryVersion 1
+
+typedef struct __attribute__((__packed__)) BatteryHistory
 {
-	updateTime(currentTime);
-	if((units & (DAY_UNIT | MONTH_UNIT)) && (gComplicationLayer != 0))
-		layer_mark_dirty(gComplicationLayer);
-	if(gDialLayer != 0)
-		layer_mark_dirty(gDialLayer);
-	if(gInnerLayer != 0)
-		layer_mark_dirty(gInnerLayer);
-}
+	uint8_t		version;
+	uint8_t		count,				// samples recorded, up to kBatterySamples
+				next;				// where the next one goes
+	uint32_t	secondsPerPercent;	// the discharge rate; 0 until the charge has dropped twice
+	struct __attribute__((__packed__))
+	{
+		uint32_t	time;			// seconds since the epoch
+		uint8_t		level;			// percent
+	}			samples[kBatterySamples];
+} BatteryHistory;
 
-static void onAccelerometerEvent(AccelAxisType axis, int32_t direction)
+static BatteryHistory gBatteryHistory = {0};
+
+static void loadBatteryHistory(void)
 {
-	;
+	if(		(persist_read_data(kPersistKeyBatteryHistory, &gBatteryHistory, sizeof(gBatteryHistory)) != sizeof(gBatteryHistory))
+		||	(gBatteryHistory.version != kBatteryHistoryVersion) || (gBatteryHistory.count > kBatterySamples)
+		||	(gBatteryHistory.next >= kBatterySamples)
+	)
+	{
+		memset(&gBatteryHistory, 0, sizeof(gBatteryHistory));
+		gBatteryHistory.version = kBatteryHistoryVersion;
+	}
 }
 
-static void onBatteryStatusChanged(BatteryChargeState charge)
+// records the charge if it's a new level, updating the discharge rate
+static void recordBatterySample(BatteryChargeState charge, time_t now)
 {
-	if(gTimeState.timeStyle & kOptionDemoMode)
+	uint32_t last = (gBatteryHistory.next + kBatterySamples - 1) % kBatterySamples;
+	int discharging = !charge.is_charging && !charge.is_plugged,
+		recorded = (gBatteryHistory.count > 0);
+
+	if(discharging? (recorded && (gBatteryHistory.samples[last].level == charge.charge_percent)) : !recorded)
+		return;
+
+	if(		discharging && recorded && (gBatteryHistory.samples[last].level > charge.charge_percent)
+		&&	((uint32_t)now > gBatteryHistory.samples[last].time)
+	)
 	{
-		gTimeState.chargeLevel = 70;
-		gTimeState.chargeState = 0;
+		// a quarter of each new interval, so one odd step doesn't swing the estimate
+		uint32_t rate = ((uint32_t)now - gBatteryHistory.samples[last].time) / (gBatteryHistory.samples[last].level - charge.charge_percent);
+		gBatteryHistory.secondsPerPercent = (gBatteryHistory.secondsPerPercent == 0)? rate
+											: ((3 * gBatteryHistory.secondsPerPercent) + rate) / 4;
 	}
 	else
 	{
-		gTimeState.chargeLevel = charge.charge_percent;
-		gTimeState.chargeState = (charge.is_charging? kChargeStateCharging : 0) | (charge.is_plugged? kChargeStatePluggedIn : 0);
+		// charging, the first level, or one that says nothing about the rate (the charge rose
+		// without charging, or the clock went back): start over
+		gBatteryHistory.count = gBatteryHistory.next = 0;
+		gBatteryHistory.secondsPerPercent = 0;
+	}
+
+	if(discharging)
+	{
+		gBatteryHistory.samples[gBatteryHistory.next].time = (uint32_t)now;
+		gBatteryHistory.samples[gBatteryHistory.next].level = charge.charge_percent;
+		gBatteryHistory.next = (gBatteryHistory.next + 1) % kBatterySamples;
+		if(gBatteryHistory.count < kBatterySamples)
+			gBatteryHistory.count++;
 	}
+	persist_write_data(kPersistKeyBatteryHistory, &gBatteryHistory, sizeof(gBatteryHistory));
+}
 
-	if(gComplicationLayer != 0)
-		layer_mark_dirty(gComplicationLayer);
+// hours of charge left at the estimated discharge rate, or -1 without an estimate
+static int32_t batteryHoursRemaining(void)
+{
+	if(gBatteryHistory.secondsPerPercent == 0)
+		return(-1);
+	return((int32_t)((gTimeState.chargeLevel * gBatteryHistory.secondsPerPercent) / 3600));
 }
 
-static void onConnectionStatusChanged(bool connected)
+#if defined(PBL_COLOR)
+typedef struct __attribute__((__packed__)) SnapshotHeader
+{
+	uint8_t		version,
+				colors;						// palette entries in use
+	uint16_t	width,
+				height,
+				size;						// bytes of runs
+	uint8_t		palette[kSnapshotColors];	// GColor8 ARGB
+} SnapshotHeader;
+
+// the runs, a persist value's worth at a time
+typedef struct SnapshotChunk
 {
-	// on the lost connection edge, if this option is selected, vibrate
-	if(!gTimeState.connectionLost && !connected && (gTimeState.timeStyle & kOptionVibrateOnDisconnect))
-		vibes_double_pulse();
+	uint8_t		data[PERSIST_DATA_MAX_LENGTH];
+	uint32_t	used,			// bytes in data
+				key,			// persist values done, before this one
+				size;			// bytes of runs, in all of them
+} SnapshotChunk;
 
-	gTimeState.connectionLost = !connected;
-	if(gComplicationLayer != 0)
-		layer_mark_dirty(gComplicationLayer);
+static uint16_t msSince(time_t seconds, uint16_t ms)
+{
+	time_t nowSeconds;
+	uint16_t nowMs;
+	time_ms(&nowSeconds, &nowMs);
+	return((uint16_t)((uint32_t)(nowSeconds - seconds) * 1000 + nowMs - ms));
 }
 
-static void onComplicationLayerRender(struct Layer* layer, GContext* context)
-{
-	GRect const bounds = layer_get_bounds(layer);
-	GPoint const center = GPoint(bounds.size.w / 2, bounds.size.h / 2);
-	
-	// paint the outer background color
-	graphics_context_set_fill_color(context, gTimeState.outerBackgroundColor);
-	graphics_fill_circle(context, center, (bounds.size.w / 2));
-	
-	// background
-	graphics_context_set_fill_color(context, gTimeState.backgroundColor);
-	graphics_fill_circle(context, center, (bounds.size.w / 2) - gTimeState.outerCircleOuterInset - 1);
+#define kSnapshotRunsMax (kSnapshotKeys * PERSIST_DATA_MAX_LENGTH)
 
-	// draw the day (-of-week) complication, e.g. "TUE" for Tuesday.
-	// the kDays string can/should be internationalized
+static int putSnapshotByte(SnapshotHeader* header, uint8_t* runs, uint8_t byte)
+{
+	if(header->size == kSnapshotRunsMax)
+		return(0);
+	runs[header->size++] = byte;
+	return(1);
+}
 
-	uint32_t	outerRadius = gTimeState.outerCircleOuterInset + gTimeState.outerCircleInnerInset + 2,
-				innerRadius = gTimeState.innerCircleOuterInset - 2,
-				midRadius = (outerRadius + innerRadius) / 2,
-				w = 20, h = 14;
+static int putSnapshotRun(SnapshotHeader* header, uint8_t* runs, uint32_t index, uint32_t run)
+{
+	if(run <= 15)
+		return(putSnapshotByte(header, runs, (index << 4) | (run - 1)));
 
-	if(!(gTimeState.timeStyle & kOptionHideWeekday))
+	if(!putSnapshotByte(header, runs, (index << 4) | 15))
+		return(0);
+	for(run -= 16; run >= 0x80; run >>= 7)
 	{
-		char dayString[4];
-		snprintf(dayString, 4, "%s", localizedDayOfWeek(gTimeState.weekDay));
-
-		GRect dayBox = GRect((bounds.size.w / 2) - w, midRadius - h, 2 * w, 2 * h);
-		graphics_context_set_text_color(context, gTimeState.complicationDayColor);
-		graphics_draw_text(		context, dayString, fonts_get_system_font(FONT_KEY_GOTHIC_18), dayBox,
-								GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
-							);
+		if(!putSnapshotByte(header, runs, 0x80 | (run & 0x7F)))
+			return(0);
 	}
-	
+	return(putSnapshotByte(header, runs, run));
+}
 
-	// draw the month complication, e.g. "FEB" for February
-	// the kMonths string can/should be internationalized
-	if(!(gTimeState.timeStyle & kOptionHideMonth))
-	{
-		char monthString[4];
+// encodes the frame into buffer, its header and then its runs, returning 0 if it has too many
+// colors or runs to keep
+static int encodeSnapshot(GBitmap* frame, uint8_t* buffer)
+{
+	time_t startSeconds;
+	uint16_t startMs;
+	time_ms(&startSeconds, &startMs);
 
-		snprintf(monthString, 4, "%s", localizedMonthName(gTimeState.months));
+	GRect const bounds = gbitmap_get_bounds(frame);
+	SnapshotHeader header = {.version = kSnapshotVersion, .width = bounds.size.w, .height = bounds.size.h, .size = 0};
+	uint8_t* runs = buffer + sizeof(header);
+	uint32_t index = 0, run = 0;
+	int fits = 1;
 
-		GRect monthBox = GRect(outerRadius, (bounds.size.h / 2) - h, innerRadius - outerRadius, 2 * h);
-		graphics_context_set_text_color(context, gTimeState.complicationMonthColor);
-		graphics_draw_text(		context, monthString, fonts_get_system_font(FONT_KEY_GOTHIC_18),
-								monthBox, GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
-							);
-	}
-	
-	if(!(gTimeState.timeStyle & kOptionHideDate))
+	for(int y = 0; fits && (y < bounds.size.h); y++)
 	{
-		// draw the date (-of-month) complication, e.g. 29
-		char dateString[3];
-
-		// option: leading-zero suppression on date
-		snprintf(dateString, 3, (gTimeState.timeStyle & kOptionDateLeadingZeroSuppression)? "%2i" : "%02i", gTimeState.days);
+		GBitmapDataRowInfo const row = gbitmap_get_data_row_info(frame, y);
+		for(int x = row.min_x; fits && (x <= row.max_x); x++)
+		{
+			uint8_t const color = row.data[x];
+			if((run > 0) && (header.palette[index] == color))
+			{
+				run++;
+				continue;
+			}
+			if(run > 0)
+				fits = putSnapshotRun(&header, runs, index, run);
 
-		GRect dateBox = GRect(bounds.size.w - innerRadius, (bounds.size.h / 2) - h - 3, innerRadius - outerRadius, 2 * h + 6);
-		graphics_context_set_text_color(context, gTimeState.complicationDateColor);
-		graphics_draw_text(		context, dateString, fonts_get_system_font(FONT_KEY_GOTHIC_24),
-								dateBox, GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
-							);
+			for(index = 0; (index < header.colors) && (header.palette[index] != color); index++)
+				;
+			if(index == header.colors)
+			{
+				if(header.colors == kSnapshotColors)
+					fits = 0;
+				else
+					header.palette[header.colors++] = color;
+			}
+			run = 1;
+		}
 	}
+	fits = fits && ((run == 0) || putSnapshotRun(&header, runs, index, run));
 
-	char chargeString[5];
-	int showBottomComplication = 0;
-	// a lost connection is more important than the battery level, unless the battery level is really low
-	if(gTimeState.connectionLost && (gTimeState.chargeLevel > 10))
+	memcpy(buffer, &header, sizeof(header));
+	gSnapshot.encodeMs = msSince(startSeconds, startMs);
+	return(fits);
+}
+
+// writes the snapshot encodeSnapshot left in buffer into persistent storage, skipping the values
+// that hold it already, or removes the last snapshot if the frame didn't fit
+static void writeSnapshot(uint8_t const* buffer, int fits)
+{
+	SnapshotHeader header;
+	memcpy(&header, buffer, sizeof(header));
+	uint8_t const* runs = buffer + sizeof(header);
+
+	uint32_t keys = fits? ((header.size + PERSIST_DATA_MAX_LENGTH - 1) / PERSIST_DATA_MAX_LENGTH) : 0;
+	for(uint32_t key = 0; key < keys; key++)
 	{
-		if(!(gTimeState.timeStyle & kOptionHideConnectionLost))
+		uint8_t stored[PERSIST_DATA_MAX_LENGTH];
+		uint32_t	offset = key * PERSIST_DATA_MAX_LENGTH,
+					length = ((header.size - offset) < PERSIST_DATA_MAX_LENGTH)? (header.size - offset) : PERSIST_DATA_MAX_LENGTH;
+		if(		(persist_read_data(kPersistKeySnapshotData + key, stored, sizeof(stored)) != (int)length)
+			||	(memcmp(stored, runs + offset, length) != 0)
+		)
 		{
-			showBottomComplication = 1;
-			graphics_context_set_text_color(context, gTimeState.complicationBatteryErrorColor);
-			snprintf(chargeString, 5, "CONN");
+			// the header that described the old runs goes first
+			if(persist_exists(kPersistKeySnapshot))
+				persist_delete(kPersistKeySnapshot);
+			persist_write_data(kPersistKeySnapshotData + key, runs + offset, length);
+			gSnapshot.writes++;
 		}
 	}
-	else if(!(gTimeState.timeStyle & kOptionHideBattery))
+
+	// the values a longer snapshot left behind, or all of them, go
+	for(uint32_t key = keys; key < kSnapshotKeys; key++)
 	{
-		showBottomComplication = 1;
-		graphics_context_set_text_color(	context, (gTimeState.chargeLevel <= 20)? gTimeState.complicationBatteryErrorColor
-													: gTimeState.complicationBatteryColor
-										);
-		
-		if(!(gTimeState.chargeState & kChargeStateCharging) && (gTimeState.chargeState & kChargeStatePluggedIn))
-			snprintf(chargeString, 5, "PLUG");
-		else
-			snprintf(chargeString, 5, "%3i%s", gTimeState.chargeLevel, (gTimeState.chargeState & kChargeStateCharging)? "+" : "%");
+		if(persist_exists(kPersistKeySnapshotData + key))
+			persist_delete(kPersistKeySnapshotData + key);
+	}
+	if(!fits)
+	{
+		persist_delete(kPersistKeySnapshot);
+		gSnapshot.skipped++;
+		return;
 	}
 
-	if(showBottomComplication)
+	// the header goes last, so a save cut short by a reset leaves no snapshot rather than a torn one
+	SnapshotHeader stored;
+	if(		(persist_read_data(kPersistKeySnapshot, &stored, sizeof(stored)) != sizeof(stored))
+		||	(memcmp(&stored, &header, sizeof(header)) != 0)
+	)
 	{
-		GRect chargeBox = GRect((bounds.size.w / 2) - w, bounds.size.h - midRadius - h, 2 * w, 2 * h);
-		graphics_draw_text(		context, chargeString, fonts_get_system_font(FONT_KEY_GOTHIC_18),
-								chargeBox, GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
-							);
+		persist_write_data(kPersistKeySnapshot, &header, sizeof(header));
+		gSnapshot.writes++;
 	}
+	gSnapshot.size = header.size;
+	gSnapshot.saves++;
 }
 
-static void onDialLayerRender(struct Layer* layer, GContext* context)
+// reads the snapshot's header, returning whether it's one a frame of this size can draw
+static int readSnapshotHeader(SnapshotHeader* header, GSize size)
 {
-	GRect bounds = layer_get_bounds(layer);
+	return(		(persist_read_data(kPersistKeySnapshot, header, sizeof(*header)) == sizeof(*header))
+			&&	(header->version == kSnapshotVersion) && (header->colors <= kSnapshotColors)
+			&&	(header->width == size.w) && (header->height == size.h)
+			&&	(header->size <= kSnapshotRunsMax)
+		);
+}
 
-	GPoint const center = GPoint(bounds.size.w / 2, bounds.size.h / 2);
+static int getSnapshotByte(SnapshotChunk* chunk, uint8_t* byte)
+{
+	if(chunk->used == chunk->size)
+		return(0);
+	if((chunk->used % sizeof(chunk->data)) == 0)
+	{
+		uint32_t length = chunk->size - chunk->used;
+		if(length > sizeof(chunk->data))
+			length = sizeof(chunk->data);
+		if(persist_read_data(kPersistKeySnapshotData + chunk->key++, chunk->data, length) != (int)length)
+			return(0);
+	}
+	*byte = chunk->data[chunk->used++ % sizeof(chunk->data)];
+	return(1);
+}
 
-	uint32_t	hourAngle = ((gTimeState.hours >= 12)? (gTimeState.hours - 12) : gTimeState.hours) * 30,
-				minuteAngle = gTimeState.minutes * 6;
+// decodes the snapshot into the frame, returning whether all of it was there
+static int drawSnapshot(GBitmap* frame)
+{
+	time_t startSeconds;
+	uint16_t startMs;
+	time_ms(&startSeconds, &startMs);
+
+	GRect const bounds = gbitmap_get_bounds(frame);
+	SnapshotHeader header;
+	if(!readSnapshotHeader(&header, bounds.size))
+		return(0);
+
+	SnapshotChunk chunk = {.used = 0, .key = 0, .size = header.size};
+	uint32_t run = 0;
+	uint8_t color = 0;
+	for(int y = 0; y < bounds.size.h; y++)
+	{
+		GBitmapDataRowInfo const row = gbitmap_get_data_row_info(frame, y);
+		for(int x = row.min_x; x <= row.max_x; x++)
+		{
+			if(run == 0)
+			{
+				uint8_t byte;
+				if(!getSnapshotByte(&chunk, &byte) || ((byte >> 4) >= header.colors))
+					return(0);
+				color = header.palette[byte >> 4];
+				run = (byte & 15) + 1;
+				for(int shift = 0, more = (run == 16); more; shift += 7)
+				{
+					if((shift > 21) || !getSnapshotByte(&chunk, &byte))
+						return(0);
+					run += (uint32_t)(byte & 0x7F) << shift;
+					more = byte & 0x80;
+				}
+			}
+			row.data[x] = color;
+			run--;
+		}
+	}
+	gSnapshot.size = header.size;
+	gSnapshot.decodeMs = msSince(startSeconds, startMs);
+	return(1);
+}
+#endif
+
+#if defined(PBL_BW)
+// Black or white for each of the 64 opaque colors (GColor8's low six bits, 2 bits each of red,
+// green and blue), by luminance (2r + 5g + b of at most 24) against the midpoint.
+#define BW(rgb)		(((2 * (((rgb) >> 4) & 3) + 5 * (((rgb) >> 2) & 3) + ((rgb) & 3)) >= 12)? 0xFF : 0xC0)
+#define BW4(rgb)	BW(rgb), BW((rgb) + 1), BW((rgb) + 2), BW((rgb) + 3)
+#define BW16(rgb)	BW4(rgb), BW4((rgb) + 4), BW4((rgb) + 8), BW4((rgb) + 12)
+static uint8_t const kBlackOrWhite[64] = {BW16(0), BW16(16), BW16(32), BW16(48)};
+#undef BW16
+#undef BW4
+#undef BW
+#endif
+
+// maps the configured colors to ones the display can show: the 1-bit displays only have black
+// and white, so a color scheme keeps its light/dark contrast rather than whatever the firmware
+// would make of it
+static void reduceColors(void)
+{
+#if defined(PBL_BW)
+	GColor* const colors[] =
+	{
+		&gTimeState.elapsedOuterColor, &gTimeState.elapsedOuterBackground,
+		&gTimeState.elapsedInnerColor, &gTimeState.elapsedInnerBackground,
+		&gTimeState.hourHandColor, &gTimeState.minuteHandColor,
+		&gTimeState.innermostBackgroundColor, &gTimeState.innermostTextColor,
+		&gTimeState.complicationMonthColor, &gTimeState.complicationDateColor,
+		&gTimeState.complicationDayColor, &gTimeState.complicationBatteryColor,
+		&gTimeState.complicationBatteryErrorColor, &gTimeState.backgroundColor,
+		&gTimeState.outerBackgroundColor,
+	};
+	for(unsigned int i = 0; i < sizeof(colors) / sizeof(colors[0]); i++)
+	{
+		if(colors[i]->argb & 0xC0)	// clear stays clear
+			colors[i]->argb = kBlackOrWhite[colors[i]->argb & 0x3F];
+	}
+#endif
+}
 
-	// option: hour hand snaps to hours rather than continuous movement
-	if(!(gTimeState.timeStyle & kOptionHourHandSnap))
-		hourAngle += (gTimeState.minutes / 2);
+int automaticLanguage(void)
+{
+	char const* iso = i18n_get_system_locale();
 	
-	// draw the outer angular section, which represents minutes
-	GRect outerCircle = GRect(		bounds.origin.x + gTimeState.outerCircleOuterInset, bounds.origin.y + gTimeState.outerCircleOuterInset,
-									bounds.size.w - (2 * gTimeState.outerCircleOuterInset), bounds.size.h - (2 * gTimeState.outerCircleOuterInset)
-								);
-	graphics_context_set_fill_color(context, gTimeState.elapsedOuterColor);
-	graphics_fill_radial(	context, outerCircle, GOvalScaleModeFillCircle,
-							gTimeState.outerCircleInnerInset, 0, DEG_TO_TRIGANGLE(minuteAngle)
-						);
-	graphics_context_set_fill_color(context, gTimeState.elapsedOuterBackground);
-	graphics_fill_radial(	context, outerCircle, GOvalScaleModeFillCircle,
-							gTimeState.outerCircleInnerInset, DEG_TO_TRIGANGLE(minuteAngle), DEG_TO_TRIGANGLE(360)
+	switch(iso[0])
+	{
+	case 'a':
+		if(iso[1] == 'r')	return(kLanguageArabic);
+		break;
+	case 'd':
+		if(iso[1] == 'e')	return(kLanguageGerman);
+		break;
+	case 'e':
+		if(iso[1] == 'n')	return(kLanguageEnglish);
+		if(iso[1] == 's')	return(kLanguageSpanish);
+		break;
+	case 'f':
+		if(iso[1] == 'r')	return(kLanguageFrench);
+		break;
+	case 'i':
+		if(iso[1] == 't')	return(kLanguageItalian);
+		break;
+	case 'n':
+		if(iso[1] == 'l')	return(kLanguageDutch);
+		break;
+	case 'p':
+		if(iso[1] == 't')	return(kLanguagePortuguese);
+		break;
+	case 'r':
+		if(iso[1] == 'u')	return(kLanguageRussian);
+		break;
+	}
+
+	return(kLanguageEnglish);	// fallback
+}
+
+// the language of the date complications, resolved from timeStyle2 (and, for kLanguageAutomatic,
+// the system locale) only when either changes rather than on every render
+static int gLanguage = kLanguageEnglish;
+
+static void resolveLanguage(void)
+{
+	gLanguage = (gTimeState.timeStyle2 & 0xFF);
+	if((gLanguage == kLanguageAutomatic) || (gLanguage > kLanguageRussian))
+		gLanguage = automaticLanguage();
+}
+
+// dayIndexZeroBased treats 0 as Sunday
+static char const* localizedDayOfWeek(int dayIndexZeroBased)
+{
+	return(kDaysOfWeek[7 * (gLanguage - 1) + dayIndexZeroBased]);
+}
+
+// monthIndexZeroBased treats 0 as January
+static char const* localizedMonthName(int monthIndexZeroBased)
+{
+	return(kMonthNames[12 * (gLanguage - 1) + monthIndexZeroBased]);
+}
+
+static void requestRedraw(int mode)
+{
+	if(mode > gRedraw.mode)
+		gRedraw.mode = mode;
+}
+
+// a delta redraw that also repaints the given kRedrawPart*s
+static void requestRedrawParts(uint32_t parts)
+{
+	requestRedraw(kRedrawDelta);
+	gRedraw.parts |= parts;
+}
+
+static void flushRedraw(void)
+{
+	gRedrawScheduler.pending = 0;
+	gRedrawScheduler.flushes++;
+	if(gFaceLayer != 0)
+		layer_mark_dirty(gFaceLayer);
+}
+
+static void onRedrawTimer(void* data)
+{
+	gRedrawScheduler.timer = 0;
+	if(gRedrawScheduler.pending)
+		flushRedraw();
+}
+
+// opens the redraw window, if it isn't open; returns whether it is
+static int openRedrawWindow(void)
+{
+	if(gRedrawScheduler.timer == 0)
+		gRedrawScheduler.timer = app_timer_register(kRedrawWindowMs, &onRedrawTimer, 0);
+	return(gRedrawScheduler.timer != 0);
+}
+
+// marks the face dirty at the end of the redraw window, opening one if there isn't one open
+static void scheduleRedraw(void)
+{
+	gRedrawScheduler.requests++;
+	if(gRedrawScheduler.pending)
+	{
+		gRedrawScheduler.merged++;
+		return;
+	}
+	gRedrawScheduler.pending = 1;
+	if(!openRedrawWindow())
+		flushRedraw();
+}
+
+// marks the face dirty at once, taking in whatever the window held, and opens a window for the
+// events that follow
+static void redrawNow(void)
+{
+	gRedrawScheduler.requests++;
+	gRedrawScheduler.merged += gRedrawScheduler.pending;
+	flushRedraw();
+	openRedrawWindow();
+}
+
+static void cancelRedraw(void)
+{
+	if(gRedrawScheduler.timer != 0)
+		app_timer_cancel(gRedrawScheduler.timer);
+	gRedrawScheduler.timer = 0;
+	gRedrawScheduler.pending = 0;
+}
+
+static void invalidateComplicationCache(void)
+{
+	gComplicationCacheValid = 0;
+}
+
+// Slot sources.  Each formats its value into string, returning 0 if there's nothing to show, and
+// sets *alert if it's to be shown in the battery error color rather than the slot's own.
+
+// the names are resolved already, so they're copied rather than formatted
+static void copyName(char* string, size_t size, char const* name)
+{
+	strncpy(string, name, size - 1);
+	string[size - 1] = '\0';
+}
+
+static int formatWeekday(char* string, size_t size, int* alert)
+{
+	if(gTimeState.timeStyle & kOptionHideWeekday)
+		return(0);
+	// e.g. "TUE" for Tuesday
+	copyName(string, size, localizedDayOfWeek(gTimeState.weekDay));
+	return(1);
+}
+
+static int formatMonth(char* string, size_t size, int* alert)
+{
+	if(gTimeState.timeStyle & kOptionHideMonth)
+		return(0);
+	// e.g. "FEB" for February
+	copyName(string, size, localizedMonthName(gTimeState.months));
+	return(1);
+}
+
+static int formatDate(char* string, size_t size, int* alert)
+{
+	if(gTimeState.timeStyle & kOptionHideDate)
+		return(0);
+	// e.g. 29; option: leading-zero suppression on date
+	snprintf(string, size, (gTimeState.timeStyle & kOptionDateLeadingZeroSuppression)? "%2i" : "%02i", gTimeState.days);
+	return(1);
+}
+
+static int formatBattery(char* string, size_t size, int* alert)
+{
+	// a lost connection is more important than the battery level, unless the battery level is really low
+	if(gTimeState.connectionLost && (gTimeState.chargeLevel > 10))
+	{
+		if(gTimeState.timeStyle & kOptionHideConnectionLost)
+			return(0);
+		*alert = 1;
+		snprintf(string, size, "CONN");
+		return(1);
+	}
+	if(gTimeState.timeStyle & kOptionHideBattery)
+		return(0);
+
+	int32_t hours = batteryHoursRemaining();
+	*alert = (gTimeState.chargeLevel <= 20);
+	if(!(gTimeState.chargeState & kChargeStateCharging) && (gTimeState.chargeState & kChargeStatePluggedIn))
+		snprintf(string, size, "PLUG");
+	else if((gTimeState.timeStyle & kOptionBatteryTimeRemaining) && !(gTimeState.chargeState & kChargeStateCharging) && (hours >= 0))
+		snprintf(string, size, (hours < 100)? "%3lih" : "%3lid", (long)((hours < 100)? hours : (hours / 24)));
+	else
+		snprintf(string, size, "%3i%s", gTimeState.chargeLevel, (gTimeState.chargeState & kChargeStateCharging)? "+" : "%");
+	return(1);
+}
+
+#if defined(PBL_HEALTH)
+
+// the metric's value, today's total or its latest reading, or -1 if the watch has none to give
+static HealthValue healthValue(HealthMetric metric, int today)
+{
+	time_t now = time(0);
+	if(!(health_service_metric_accessible(metric, today? time_start_of_today() : now, now) & HealthServiceAccessibilityMaskAvailable))
+		return(-1);
+	return(today? health_service_sum_today(metric) : health_service_peek_current_value(metric));
+}
+
+static int formatSteps(char* string, size_t size, int* alert)
+{
+	// e.g. 8421, 12.5k, 104k
+	HealthValue steps = healthValue(HealthMetricStepCount, 1);
+	if(steps < 0)
+		snprintf(string, size, "--");
+	else if(steps < 10000)
+		snprintf(string, size, "%li", (long)steps);
+	else if(steps < 100000)
+		snprintf(string, size, "%li.%lik", (long)(steps / 1000), (long)((steps / 100) % 10));
+	else
+		snprintf(string, size, "%lik", (long)(steps / 1000));
+	return(1);
+}
+
+static int formatHeartRate(char* string, size_t size, int* alert)
+{
+	HealthValue bpm = healthValue(HealthMetricHeartRateBPM, 0);
+	if(bpm > 0)
+		snprintf(string, size, "%libpm", (long)bpm);
+	else
+		snprintf(string, size, "--");
+	return(1);
+}
+
+#else
+
+// aplite has no HealthService
+static int formatUnavailable(char* string, size_t size, int* alert)
+{
+	snprintf(string, size, "--");
+	return(1);
+}
+
+#endif
+
+static int formatSecondZone(char* string, size_t size, int* alert)
+{
+	// the time in the zone offset from UTC, in the digital time's style
+	time_t zone = time(0) + (int8_t)(gTimeState.complications >> 16) * (15 * 60);
+	struct tm const* zoneTime = gmtime(&zone);
+	int h = zoneTime->tm_hour;
+	if((gTimeState.timeStyle & kOption12HourTime) && (h > 12))
+		h -= 12;
+	snprintf(	string, size, ((gTimeState.timeStyle & kOptionHourLeadingZeroSuppression) && (h < 10))? "%i:%02i" : "%02i:%02i",
+				h, zoneTime->tm_min
+			);
+	return(1);
+}
+
+// what formats each source, and how many minute ticks apart; 0 if only its own events change it
+static struct ComplicationSource
+{
+	int			(*format)(char* string, size_t size, int* alert);
+	uint8_t		refreshMinutes;
+} const kComplicationSources[kSourceCount] =
+{
+	[kSourceNone] = {0, 0},
+	[kSourceWeekday] = {&formatWeekday, 0},		// the day changing
+	[kSourceMonth] = {&formatMonth, 0},
+	[kSourceDate] = {&formatDate, 0},
+	[kSourceBattery] = {&formatBattery, 0},		// the battery and connection services
+#if defined(PBL_HEALTH)
+	[kSourceSteps] = {&formatSteps, 5},
+	[kSourceHeartRate] = {&formatHeartRate, 5},
+#else
+	[kSourceSteps] = {&formatUnavailable, 0},
+	[kSourceHeartRate] = {&formatUnavailable, 0},
+#endif
+	[kSourceSecondZone] = {&formatSecondZone, 1},
+};
+
+// the color a slot's text takes, as the default source in its place had it
+static GColor slotColor(struct TimeState const* state, int slot)
+{
+	switch(slot)
+	{
+	case kSlotTop:		return(state->complicationDayColor);
+	case kSlotLeft:		return(state->complicationMonthColor);
+	case kSlotRight:	return(state->complicationDateColor);
+	}
+	return(state->complicationBatteryColor);
+}
+
+// whether the slot is drawn into the complication cache
+static int slotIsCached(int slot)
+{
+	return((kSourceBit(gSlots.slots[slot].source) & kSourcesDaily) != 0);
+}
+
+// of the given slots (bit s for slot s), those drawn over the complication cache every time
+static uint32_t liveSlots(uint32_t slots)
+{
+	for(int s = 0; s < kSlotCount; s++)
+	{
+		if(slotIsCached(s))
+			slots &= ~(1 << s);
+	}
+	return(slots);
+}
+
+// formats the given sources (kSourceBit()s) into the slots bound to them, and any slot whose
+// binding changed, returning the slots whose text or color changed
+static uint32_t refreshSlots(uint32_t sources)
+{
+	uint32_t changed = 0;
+	for(int s = 0; s < kSlotCount; s++)
+	{
+		struct ComplicationSlot* slot = &gSlots.slots[s];
+		uint32_t source = ((gTimeState.complications >> (4 * s)) & 0xF);
+		if(source >= kSourceCount)
+			source = kSourceNone;
+		if(!(sources & kSourceBit(source)) && (source == slot->source))
+			continue;
+
+		struct ComplicationSlot after = {.source = source};
+		int alert = 0;
+		if(kComplicationSources[source].format != 0)
+		{
+			after.shown = kComplicationSources[source].format(after.text, sizeof(after.text), &alert);
+			gSlots.formats++;
+		}
+		after.color = alert? gTimeState.complicationBatteryErrorColor : slotColor(&gTimeState, s);
+
+		if(		(after.source == slot->source) && (after.shown == slot->shown)
+			&&	(!after.shown || ((strcmp(after.text, slot->text) == 0) && (after.color.argb == slot->color.argb)))
+		)
+			continue;
+		*slot = after;
+		changed |= (1 << s);
+	}
+	gSlots.unmeasured |= changed;
+	return(changed);
+}
+
+// the sources due to be formatted again on this minute tick
+static uint32_t dueSources(void)
+{
+	uint32_t due = 0;
+	for(int source = 0; source < kSourceCount; source++)
+	{
+		uint32_t minutes = kComplicationSources[source].refreshMinutes;
+		if((minutes > 0) && (++gSlots.minutes[source] >= minutes))
+		{
+			gSlots.minutes[source] = 0;
+			due |= kSourceBit(source);
+		}
+	}
+	return(due);
+}
+
+// asks for the slots refreshSlots() found changed to be redrawn, returning whether there were any:
+// a cached slot takes the cache with it, the others are repainted on their own
+static int redrawChangedSlots(uint32_t changed)
+{
+	if(changed == 0)
+		return(0);
+
+	if(liveSlots(changed) != changed)
+	{
+		invalidateComplicationCache();
+		requestRedraw(kRedrawFull);
+	}
+	else
+	{
+		gSlots.dirty |= changed;
+		requestRedrawParts(kRedrawPartSlots);
+	}
+	return(1);
+}
+
+static void updateTime(struct tm const* currentTime)
+{
+	if(gTimeState.timeStyle & kOptionDemoMode)
+	{
+		gTimeState.hours = 1;
+		gTimeState.minutes = 50;
+		gTimeState.seconds = 0;
+		gTimeState.days = 4;
+		gTimeState.months = 3;
+		gTimeState.weekDay = 5;
+	}
+	else
+	{
+		gTimeState.hours = currentTime->tm_hour;
+		gTimeState.minutes = currentTime->tm_min;
+		gTimeState.seconds = currentTime->tm_sec;
+		gTimeState.days = currentTime->tm_mday;
+		gTimeState.months = currentTime->tm_mon;
+		gTimeState.weekDay = currentTime->tm_wday;
+	}
+}
+
+// the minutes between redraws at this time: the quiet hours' interval within them, unless a tap
+// woke the face, and 1 otherwise
+static uint32_t quietInterval(struct tm const* currentTime)
+{
+	uint32_t	start = (gTimeState.quietHours & 0xFF),
+				end = ((gTimeState.quietHours >> 8) & 0xFF),
+				interval = ((gTimeState.quietHours >> 16) & 0xFF),
+				hour = currentTime->tm_hour;
+
+	if((interval <= 1) || (start == end) || (gQuietHours.wakeMinutes > 0))
+		return(1);
+	// the window may span midnight
+	return(((start < end)? ((hour >= start) && (hour < end)) : ((hour >= start) || (hour < end)))? interval : 1);
+}
+
+// dial angles in degrees, clockwise from 12 o'clock: those of the sweep's frame while it runs
+static void currentDialAngles(uint32_t* minuteAngle, uint32_t* hourAngle)
+{
+#if SWEEP_ON_APPEAR
+	if(gSweep.animation != 0)
+	{
+		*minuteAngle = gSweep.minuteAngles[gSweep.frame];
+		*hourAngle = gSweep.hourAngles[gSweep.frame];
+		return;
+	}
+#endif
+
+	*hourAngle = ((gTimeState.hours >= 12)? (gTimeState.hours - 12) : gTimeState.hours) * 30;
+	*minuteAngle = gTimeState.minutes * 6;
+
+	// option: hour hand snaps to hours rather than continuous movement
+	if(!(gTimeState.timeStyle & kOptionHourHandSnap))
+		*hourAngle += (gTimeState.minutes / 2);
+}
+
+#if SWEEP_ON_APPEAR
+static void onSweepUpdate(Animation* animation, AnimationProgress const progress)
+{
+	uint32_t frame = ((uint32_t)progress * kSweepFrames + ANIMATION_NORMALIZED_MAX / 2) / ANIMATION_NORMALIZED_MAX;
+	if(frame > kSweepFrames - 1)
+		frame = kSweepFrames - 1;
+	if(frame <= gSweep.frame)
+		return;
+
+	// the frames the timer stepped over, and the last one if it wasn't drawn in time
+	gSweep.framesDropped += frame - gSweep.frame - 1 + !gSweep.drawn;
+	gSweep.frame = frame;
+	gSweep.drawn = 0;
+
+	PROFILE_CAUSE(kProfileCauseSweep);
+	requestRedraw(kRedrawDelta);
+	if(gFaceLayer != 0)
+		layer_mark_dirty(gFaceLayer);
+}
+
+static void onSweepStopped(Animation* animation, bool finished, void* context)
+{
+	gSweep.animation = 0;
+	gSweep.cancelled += (gSweep.frame != kSweepFrames - 1);
+	if(gSweep.framesDropped > 0)
+		APP_LOG(APP_LOG_LEVEL_WARNING, "sweep: %u of %u frames dropped", (unsigned int)gSweep.framesDropped, kSweepFrames);
+
+	// cut short (or the time's angles changed under it), the face goes straight to the time
+	uint32_t minuteAngle, hourAngle;
+	currentDialAngles(&minuteAngle, &hourAngle);
+	if((minuteAngle != gRedraw.minuteAngle) || (hourAngle != gRedraw.hourAngle))
+	{
+		requestRedraw(kRedrawDelta);
+		if(gFaceLayer != 0)
+			layer_mark_dirty(gFaceLayer);
+	}
+}
+
+// works out every frame's angles, eased out, and starts the sweep, the first time the face opens
+static void startSweep(void)
+{
+	BatteryChargeState const charge = battery_state_service_peek();
+	if(gSweep.played || ((charge.charge_percent <= kSweepMinCharge) && !charge.is_plugged))
+		return;
+	gSweep.played = 1;
+
+	uint32_t minuteAngle, hourAngle;
+	currentDialAngles(&minuteAngle, &hourAngle);
+	uint32_t const whole = (kSweepFrames - 1) * (kSweepFrames - 1) * (kSweepFrames - 1);
+	for(int f = 0; f < kSweepFrames; f++)
+	{
+		// the minute hand only stops on whole minutes
+		uint32_t const rest = kSweepFrames - 1 - f, left = rest * rest * rest;
+		gSweep.minuteAngles[f] = (minuteAngle / 6 - (minuteAngle / 6) * left / whole) * 6;
+		gSweep.hourAngles[f] = hourAngle - hourAngle * left / whole;
+	}
+
+	static AnimationImplementation const implementation = {.update = &onSweepUpdate};
+	Animation* animation = animation_create();
+	if(animation == 0)
+		return;
+	animation_set_duration(animation, kSweepFrames * kSweepFrameMs);
+	animation_set_curve(animation, AnimationCurveLinear);
+	animation_set_implementation(animation, &implementation);
+	animation_set_handlers(animation, (AnimationHandlers){.stopped = &onSweepStopped}, 0);
+
+	gSweep.frame = 0;
+	gSweep.drawn = 0;
+	gSweep.animation = animation;
+	if(!animation_schedule(animation))
+	{
+		gSweep.animation = 0;
+		animation_destroy(animation);
+	}
+}
+
+// a tap or a tick ends the sweep where it is, and the face shows the time
+static void cancelSweep(void)
+{
+	if(gSweep.animation != 0)
+		animation_unschedule(gSweep.animation);
+}
+#define sweepRunning()	(gSweep.animation != 0)
+#else
+#define startSweep()	do {} while(0)
+#define cancelSweep()	do {} while(0)
+#define sweepRunning()	0
+#endif
+
+static void onTimeChanged(struct tm* currentTime, TimeUnits units)
+{
+	cancelSweep();
+	updateTime(currentTime);
+
+	if(units & MINUTE_UNIT)
+	{
+		if(gQuietHours.wakeMinutes > 0)
+			gQuietHours.wakeMinutes--;
+
+		// in quiet hours, a minute between intervals only moves the time on; whatever redraws next
+		// shows it (the hour changing always lands on an interval)
+		uint32_t interval = quietInterval(currentTime);
+		if((interval > 1) && ((currentTime->tm_min % interval) != 0) && (gSecondsBurst.remaining == 0))
+		{
+			gQuietHours.ticksSkipped++;
+			return;
+		}
+	}
+	PROFILE_CAUSE((units & kMinuteTickUnits)? kProfileCauseTick : kProfileCauseSecondsTick);
+
+	if(gSecondsBurst.remaining > 0)
+	{
+		// the last tick of the burst clears the sweep
+		if(--gSecondsBurst.remaining == 0)
+			tick_timer_service_subscribe(kMinuteTickUnits, &onTimeChanged);
+		requestRedrawParts(kRedrawPartSecondsSweep);
+		if(!(units & kMinuteTickUnits))
+		{
+			gSecondsBurst.redraws++;
+			redrawNow();
+			return;
+		}
+	}
+
+#if defined(PBL_COLOR)
+	if(units & DAY_UNIT)
+		gSnapshot.due = 1;
+#endif
+
+	// the hour wrapping changes the inner ring's colors
+	requestRedraw((units & (HOUR_UNIT | DAY_UNIT | MONTH_UNIT | YEAR_UNIT))? kRedrawFull : kRedrawDelta);
+
+	// the date's slots change with the day, and the others as often as their sources refresh
+	redrawChangedSlots(refreshSlots(	((units & MINUTE_UNIT)? dueSources() : 0)
+									|	((units & (DAY_UNIT | MONTH_UNIT | YEAR_UNIT))? kSourcesDaily : 0)
+								));
+	redrawNow();
+}
+
+static void onAccelerometerEvent(AccelAxisType axis, int32_t direction)
+{
+#if PROFILE_RENDERING
+	profileDump();
+#endif
+	cancelSweep();
+
+	// a tap in quiet hours brings the face up to date and keeps it so for a while
+	time_t now;
+	time(&now);
+	if(quietInterval(localtime(&now)) > 1)
+	{
+		gQuietHours.wakeMinutes = kQuietWakeMinutes;
+		updateTime(localtime(&now));
+		PROFILE_CAUSE(kProfileCauseTap);
+		requestRedraw(kRedrawDelta);
+	}
+
+	uint32_t seconds = ((gTimeState.timeStyle2 >> 8) & 0xFF);
+	if((seconds == 0) || (gTimeState.timeStyle & kOptionDemoMode))
+	{
+		if(gRedraw.mode != kRedrawNone)	// quiet hours asked for one
+			scheduleRedraw();
+		return;
+	}
+
+	// another tap during a burst restarts its window
+	if(gSecondsBurst.remaining == 0)
+	{
+		gSecondsBurst.bursts++;
+		tick_timer_service_subscribe(kMinuteTickUnits | SECOND_UNIT, &onTimeChanged);
+	}
+	gSecondsBurst.remaining = (seconds < kSecondsBurstMax)? seconds : kSecondsBurstMax;
+
+	updateTime(localtime(&now));
+
+	PROFILE_CAUSE(kProfileCauseTap);
+	requestRedrawParts(kRedrawPartSecondsSweep);
+	scheduleRedraw();
+}
+
+static void onBatteryStatusChanged(BatteryChargeState charge)
+{
+	// the service calls back more often than what the slots show changes
+	if(gTimeState.timeStyle & kOptionDemoMode)
+	{
+		gTimeState.chargeLevel = 70;
+		gTimeState.chargeState = 0;
+	}
+	else
+	{
+		gTimeState.chargeLevel = charge.charge_percent;
+		gTimeState.chargeState = (charge.is_charging? kChargeStateCharging : 0) | (charge.is_plugged? kChargeStatePluggedIn : 0);
+		recordBatterySample(charge, time(0));
+	}
+
+	if(redrawChangedSlots(refreshSlots(kSourceBit(kSourceBattery))))
+	{
+		PROFILE_CAUSE(kProfileCauseBattery);
+		scheduleRedraw();
+	}
+}
+
+static void onConnectionDelayElapsed(void* data)
+{
+	gConnection.pending = 0;
+	if(gTimeState.connectionLost)
+		return;
+
+	// on the lost connection edge, if this option is selected, vibrate, unless it just did
+	if(gTimeState.timeStyle & kOptionVibrateOnDisconnect)
+	{
+		time_t now = time(0);
+		if((gConnection.lastVibration != 0) && ((now - gConnection.lastVibration) < kConnectionVibrateCooldown))
+			gConnection.vibrationsSuppressed++;
+		else
+		{
+			vibes_double_pulse();
+			gConnection.lastVibration = now;
+		}
+	}
+
+	gTimeState.connectionLost = 1;
+	if(redrawChangedSlots(refreshSlots(kSourceBit(kSourceBattery))))
+	{
+		PROFILE_CAUSE(kProfileCauseConnection);
+		scheduleRedraw();
+	}
+}
+
+static void onConnectionStatusChanged(bool connected)
+{
+	if(connected)
+	{
+		// back within the delay: nothing to show for it
+		if(gConnection.pending != 0)
+		{
+			app_timer_cancel(gConnection.pending);
+			gConnection.pending = 0;
+			gConnection.flapsAbsorbed++;
+			return;
+		}
+
+		gTimeState.connectionLost = 0;
+		if(redrawChangedSlots(refreshSlots(kSourceBit(kSourceBattery))))
+		{
+			PROFILE_CAUSE(kProfileCauseConnection);
+			scheduleRedraw();
+		}
+		return;
+	}
+
+	if((gConnection.pending != 0) || gTimeState.connectionLost)
+		return;
+
+	uint32_t delay = ((gTimeState.timeStyle2 >> 16) & 0xFF);
+	if(delay > kConnectionDelayMax)
+		delay = kConnectionDelayMax;
+	if(delay > 0)
+		gConnection.pending = app_timer_register(delay * 1000, &onConnectionDelayElapsed, 0);
+	if(gConnection.pending == 0)
+		onConnectionDelayElapsed(0);
+}
+
+static GRect insetCircle(GRect bounds, uint32_t inset)
+{
+	return(GRect(	bounds.origin.x + inset, bounds.origin.y + inset,
+					bounds.size.w - (2 * inset), bounds.size.h - (2 * inset)
+				));
+}
+
+// does the sector [angleStart, angleEnd) overlap boxSector, one of the box sectors in gLayout?
+static int sectorIntersectsBox(int16_t const* boxSector, int32_t angleStart, int32_t angleEnd)
+{
+	if((angleEnd - angleStart) >= 360)
+		return(1);
+
+	return(	(((boxSector[0] - angleStart) % 360 + 360) % 360 < (angleEnd - angleStart))
+			|| (((angleStart - boxSector[0]) % 360 + 360) % 360 < (boxSector[1] - boxSector[0]))
+		);
+}
+
+// the sector (degrees) around the center of bounds that covers box, which mustn't contain the
+// center; angleStart may be negative
+static void boxSector(GRect bounds, GRect box, int32_t* angleStart, int32_t* angleEnd)
+{
+	int32_t	cx = bounds.origin.x + (bounds.size.w / 2),
+			cy = bounds.origin.y + (bounds.size.h / 2),
+			mid = TRIGANGLE_TO_DEG(atan2_lookup(box.origin.x + (box.size.w / 2) - cx, cy - box.origin.y - (box.size.h / 2))),
+			lo = 180, hi = -180;
+	for(int corner = 0; corner < 4; corner++)
+	{
+		int32_t	dx = box.origin.x + ((corner & 1)? box.size.w : 0) - cx,
+				dy = box.origin.y + ((corner & 2)? box.size.h : 0) - cy,
+				angle = TRIGANGLE_TO_DEG(atan2_lookup(dx, -dy)),
+				relative = ((angle - mid + 540) % 360) - 180;
+		if(relative < lo)	lo = relative;
+		if(relative > hi)	hi = relative;
+	}
+	*angleStart = mid + lo - 1;
+	*angleEnd = mid + hi + 1;
+}
+
+// fills [angleStart, angleEnd) degrees of a ring; the range may extend below 0 or past 360
+static void fillRingSector(GContext* context, GRect circle, uint32_t thickness, int32_t angleStart, int32_t angleEnd)
+{
+	if(angleStart < 0)
+	{
+		fillRingSector(context, circle, thickness, angleStart + 360, 360);
+		angleStart = 0;
+	}
+	if(angleEnd > 360)
+	{
+		fillRingSector(context, circle, thickness, 0, angleEnd - 360);
+		angleEnd = 360;
+	}
+	if(angleEnd > angleStart)
+	{
+		graphics_fill_radial(	context, circle, GOvalScaleModeFillCircle,
+								thickness, DEG_TO_TRIGANGLE(angleStart), DEG_TO_TRIGANGLE(angleEnd)
+							);
+	}
+}
+
+#if defined(PBL_COLOR)
+// The insides of the rings are rasterized here rather than by graphics_fill_radial, straight into
+// the framebuffer: each row of a ring is one or two spans, looked up in gLayout.ringSpans, and
+// each span is split where the sector's edges and the elapsed angle cross it and filled with
+// memset.  The spans stop a pixel short of the ring's edges, whose antialiasing paintRingEdges
+// leaves to graphics_fill_radial.
+// The edges are the directions of DEG_TO_TRIGANGLE(0..89) (sin, cos), scaled by 2^30 so that no
+// pixel center on these displays lands on the wrong side of one; the other quadrants rotate them.
+static int32_t const kDegreeDirections[90][2] =
+{
+	{0, 1073741824}, {18734804, 1073578368}, {37463904, 1073088049},
+	{56181598, 1072271016}, {74882187, 1071127519}, {93559977, 1069657906},
+	{112209281, 1067862623}, {130824423, 1065742218}, {149399733, 1063297336},
+	{167929557, 1060528721}, {186408253, 1057437217}, {204830195, 1054023764},
+	{223189774, 1050289403}, {241481401, 1046235269}, {259699506, 1041862597},
+	{277838542, 1037172719}, {295892988, 1032167062}, {313857346, 1026847151},
+	{331726146, 1021214605}, {349493949, 1015271138}, {367155344, 1009018562},
+	{384704955, 1002458778}, {402137438, 995593785}, {419542249, 988385454},
+	{436723875, 980914757}, {453772537, 973145410}, {470683042, 965079778},
+	{487450242, 956720317}, {504069033, 948069572}, {520534355, 939130177},
+	{536841194, 929904853}, {552984587, 920396410}, {568959616, 910607742},
+	{584761420, 900541829}, {600385187, 890201737}, {615826160, 879590612},
+	{631079638, 868711687}, {646140977, 857568273}, {661005591, 846163763},
+	{675668955, 834501629}, {690126603, 822585422}, {704374136, 810418769},
+	{718407213, 798005376}, {732221564, 785349021}, {745812982, 772453559},
+	{759250125, 759250125}, {772382051, 745887037}, {785278817, 732296855},
+	{797936496, 718483718}, {810351235, 704451830}, {822519253, 690205465},
+	{834436846, 675748958}, {846100386, 661086713}, {857506321, 646223192},
+	{868651179, 631162922}, {879531567, 615910487}, {890144171, 600470531},
+	{900485762, 584847756}, {910553189, 569046917}, {920343389, 553072826},
+	{929853380, 536930345}, {939080267, 520624391}, {948021241, 504159926},
+	{956673579, 487541965}, {965034648, 470775566}, {973101901, 453865834},
+	{980872882, 436817917}, {988345227, 419637007}, {995555226, 402232888},
+	{1002421891, 384801063}, {1008983356, 367252081}, {1015237626, 349591285},
+	{1021182796, 331824052}, {1026817055, 313955792}, {1032138689, 295991944},
+	{1037146077, 277937979}, {1041837694, 259799392}, {1046212112, 241581706},
+	{1050268000, 223290469}, {1054004122, 204931247}, {1057419340, 186509633},
+	{1060512616, 168031233}, {1063283007, 149501675}, {1065729670, 130926599},
+	{1067851860, 112311661}, {1069648931, 93662529}, {1071120335, 74984880},
+	{1072265625, 56284401}, {1073084452, 37566785}, {1073576567, 18837732},
+};
+
+struct RingEdge
+{
+	int32_t		angle, sin, cos;
+};
+
+// the direction of the edge of a sector at angle degrees, rotated from the first quadrant's
+static struct RingEdge ringEdge(int32_t angle)
+{
+	int32_t degrees = (angle < 0)? 0 : (angle > 360)? 360 : angle;
+	struct RingEdge edge = {angle, kDegreeDirections[degrees % 90][0], kDegreeDirections[degrees % 90][1]};
+	for(int32_t quarter = degrees / 90; quarter > 0; quarter--)
+	{
+		int32_t t = edge.sin;
+		edge.sin = edge.cos;
+		edge.cos = -t;
+	}
+	return(edge);
+}
+
+// whether the angle of the pixel center (x, y) (doubled, relative to the center, so both odd) is
+// less than the edge's
+static int angleBefore(int32_t x, int32_t y, struct RingEdge const* edge)
+{
+	if(edge->angle <= 0)
+		return(0);
+	if(edge->angle >= 360)
+		return(1);
+	// the right half of the dial is (0, 180) degrees and the left half (180, 360)
+	if(x > 0)
+	{
+		if(edge->angle >= 180)
+			return(1);
+	}
+	else if(edge->angle <= 180)
+		return(0);
+
+	// the pixel is counterclockwise of the edge's direction
+	return(((int64_t)-edge->cos * x - (int64_t)edge->sin * y) > 0);
+}
+
+// the number of pixels of the span [xa, xb] on row y (doubled coordinates as above, xa on the
+// same side as xb) whose angle is before the edge's; increasing: angles increase with x along it
+static int32_t spanCountBefore(int32_t xa, int32_t xb, int32_t y, int increasing, struct RingEdge const* edge)
+{
+	int32_t length = (xb - xa) / 2 + 1, lo = 0, hi = length;
+
+	// the i-th pixel in order of angle
+	#define SPAN_PIXEL(i)	(increasing? (xa + 2 * (i)) : (xb - 2 * (i)))
+	if(!angleBefore(SPAN_PIXEL(0), y, edge))
+		return(0);
+	if(angleBefore(SPAN_PIXEL(length - 1), y, edge))
+		return(length);
+	while(hi - lo > 1)
+	{
+		int32_t mid = (lo + hi) / 2;
+		if(angleBefore(SPAN_PIXEL(mid), y, edge))
+			lo = mid;
+		else
+			hi = mid;
+	}
+	#undef SPAN_PIXEL
+	return(hi);
+}
+
+static void fillSpanRun(GBitmapDataRowInfo const* row, int32_t from, int32_t to, GColor color)
+{
+	if(from < row->min_x)	from = row->min_x;
+	if(to > row->max_x)		to = row->max_x;
+	if((to >= from) && (color.argb & 0xC0))
+		memset(&row->data[from], color.argb, to - from + 1);
+}
+
+// paints the sector [angleStart, angleEnd) (within [0, 360]) of the ring as paintRingSector does,
+// returning 0 if the framebuffer isn't available
+static int paintRingSpans(	GContext* context, struct RingSpans const* spans, int32_t splitAngle,
+							GColor elapsedColor, GColor remainingColor, int32_t angleStart, int32_t angleEnd
+						)
+{
+	GBitmap* frame = graphics_capture_frame_buffer(context);
+	if(frame == 0)
+		return(0);
+
+	GRect const frameBounds = gbitmap_get_bounds(frame);
+	struct RingEdge const	start = ringEdge(angleStart), end = ringEdge(angleEnd), split = ringEdge(splitAngle);
+	int32_t	radius = spans->circle.size.w / 2,
+			innerRadius = radius - (int32_t)spans->thickness,
+			cx = spans->circle.origin.x + radius,
+			cy = spans->circle.origin.y + radius;
+
+	// only the rows the sector reaches: those between its edges' ends, and the top and bottom of
+	// the ring if it passes 0 or 180 degrees, with a row's margin for rounding
+	int32_t	ends[4] =	{	(-(int64_t)start.cos * radius) >> 30, (-(int64_t)start.cos * innerRadius) >> 30,
+							(-(int64_t)end.cos * radius) >> 30, (-(int64_t)end.cos * innerRadius) >> 30
+						},
+			top = ends[0], bottom = ends[0];
+	for(int i = 1; i < 4; i++)
+	{
+		if(ends[i] < top)		top = ends[i];
+		if(ends[i] > bottom)	bottom = ends[i];
+	}
+	if(angleStart <= 0)
+		top = -radius;
+	if((angleStart < 180) && (angleEnd > 180))
+		bottom = radius;
+	top = (cy + top - 1 > cy - radius)? (cy + top - 1) : (cy - radius);
+	bottom = (cy + bottom + 1 < cy + radius)? (cy + bottom + 1) : (cy + radius - 1);
+
+	for(int32_t y = top; y <= bottom; y++)
+	{
+		int32_t k = (y >= cy)? (y - cy) : (cy - 1 - y), outer = spans->outer[k], inner = spans->inner[k];
+		if((y < 0) || (y >= frameBounds.size.h) || (outer <= inner))
+			continue;
+
+		GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame, y);
+		int32_t dy = 2 * (y - cy) + 1;
+
+		// the left span, then the right; along either, angles increase with x above the center
+		for(int side = 0; side < 2; side++)
+		{
+			int32_t	xa = side? (cx + inner) : (cx - outer),
+					xb = side? (cx + outer - 1) : (cx - inner - 1),
+					dxa = 2 * (xa - cx) + 1, dxb = 2 * (xb - cx) + 1;
+			int increasing = (dy < 0);
+
+			int32_t	first = spanCountBefore(dxa, dxb, dy, increasing, &start),
+					last = spanCountBefore(dxa, dxb, dy, increasing, &end);
+			if(last <= first)
+				continue;
+			int32_t	middle = spanCountBefore(dxa, dxb, dy, increasing, &split),
+					elapsedEnd = (last < middle)? last : middle,
+					remainingStart = (first > middle)? first : middle;
+
+			// runs are [first, last) in order of angle
+			if(increasing)
+			{
+				fillSpanRun(&row, xa + first, xa + elapsedEnd - 1, elapsedColor);
+				fillSpanRun(&row, xa + remainingStart, xa + last - 1, remainingColor);
+			}
+			else
+			{
+				fillSpanRun(&row, xb - elapsedEnd + 1, xb - first, elapsedColor);
+				fillSpanRun(&row, xb - last + 1, xb - remainingStart, remainingColor);
+			}
+		}
+	}
+
+	graphics_release_frame_buffer(context, frame);
+	return(1);
+}
+#endif
+
+// the pixels of each row of circle at least a pixel inside its edge and more than a pixel outside
+// thickness inside it, as RingSpans
+static void buildRingSpans(struct RingSpans* spans, GRect circle, uint32_t thickness)
+{
+	int32_t	radius = circle.size.w / 2 - 1,
+			innerRadius = radius - (int32_t)thickness + 2,
+			outer = radius, inner = (innerRadius > 0)? innerRadius : 0;
+
+	spans->circle = circle;
+	spans->thickness = thickness;
+	memset(spans->outer, 0, sizeof(spans->outer));
+	memset(spans->inner, 0, sizeof(spans->inner));
+
+	// pixel centers (doubled) 2n - 1 either side of the center column, on row 2k + 1, are within
+	// a radius r when (2n - 1)^2 + (2k + 1)^2 < 4r^2
+	for(int32_t k = 0; (k < radius) && (k < (int32_t)sizeof(spans->outer)); k++)
+	{
+		int32_t y2 = (2 * k + 1) * (2 * k + 1);
+		while((outer > 0) && (((2 * outer - 1) * (2 * outer - 1) + y2) >= (4 * radius * radius)))
+			outer--;
+		while((inner > 0) && (((2 * inner - 1) * (2 * inner - 1) + y2) >= (4 * innerRadius * innerRadius)))
+			inner--;
+		spans->outer[k] = outer;
+		spans->inner[k] = inner;
+	}
+}
+
+#if defined(PBL_COLOR)
+// antialiases the sector [angleStart, angleEnd) of a ring whose inside paintRingSpans has just
+// painted: a band kRingEdgeWidth wide along each of its edges, each color up to or from
+// splitAngle, and a degree's sliver of each color either side of the split between them, so
+// each color is blended over the other there as graphics_fill_radial would
+static void paintRingEdges(	GContext* context, GRect circle, uint32_t thickness, int32_t splitAngle,
+							GColor elapsedColor, GColor remainingColor, int32_t angleStart, int32_t angleEnd
+						)
+{
+	GRect const	innerEdge = insetCircle(circle, thickness - kRingEdgeWidth),
+				inside = insetCircle(circle, kRingEdgeWidth);
+	int32_t	elapsedEnd = (angleEnd < splitAngle)? angleEnd : splitAngle,
+			remainingStart = (angleStart > splitAngle)? angleStart : splitAngle;
+	int split = (splitAngle >= angleStart) && (splitAngle <= angleEnd);
+
+	graphics_context_set_fill_color(context, elapsedColor);
+	fillRingSector(context, circle, kRingEdgeWidth, angleStart, elapsedEnd);
+	fillRingSector(context, innerEdge, kRingEdgeWidth, angleStart, elapsedEnd);
+	if(split)
+		fillRingSector(context, inside, thickness - 2 * kRingEdgeWidth, (splitAngle - 1 > angleStart)? (splitAngle - 1) : angleStart, splitAngle);
+
+	graphics_context_set_fill_color(context, remainingColor);
+	fillRingSector(context, circle, kRingEdgeWidth, remainingStart, angleEnd);
+	fillRingSector(context, innerEdge, kRingEdgeWidth, remainingStart, angleEnd);
+	if(split)
+		fillRingSector(context, inside, thickness - 2 * kRingEdgeWidth, splitAngle, (splitAngle + 1 < angleEnd)? (splitAngle + 1) : angleEnd);
+}
+#endif
+
+// paints [angleStart, angleEnd) of a ring drawn in elapsedColor up to splitAngle and remainingColor after it
+static void paintRingSector(	GContext* context, GRect circle, uint32_t thickness, int32_t splitAngle,
+								GColor elapsedColor, GColor remainingColor, int32_t angleStart, int32_t angleEnd
+							)
+{
+	if(angleStart < 0)
+	{
+		paintRingSector(context, circle, thickness, splitAngle, elapsedColor, remainingColor, angleStart + 360, 360);
+		angleStart = 0;
+	}
+	if(angleEnd > 360)
+	{
+		paintRingSector(context, circle, thickness, splitAngle, elapsedColor, remainingColor, 0, angleEnd - 360);
+		angleEnd = 360;
+	}
+
+#if defined(PBL_COLOR)
+	for(unsigned int i = 0; (thickness >= kRingSpanThicknessMin) && (i < sizeof(gLayout.ringSpans) / sizeof(gLayout.ringSpans[0])); i++)
+	{
+		struct RingSpans const* spans = &gLayout.ringSpans[i];
+		if(		(spans->thickness == thickness) && (spans->circle.size.w == circle.size.w)
+			&&	(spans->circle.origin.x == circle.origin.x) && (spans->circle.origin.y == circle.origin.y)
+		)
+		{
+			if((angleEnd > angleStart) && paintRingSpans(context, spans, splitAngle, elapsedColor, remainingColor, angleStart, angleEnd))
+			{
+				paintRingEdges(context, circle, thickness, splitAngle, elapsedColor, remainingColor, angleStart, angleEnd);
+				return;
+			}
+			break;
+		}
+	}
+#endif
+
+	graphics_context_set_fill_color(context, elapsedColor);
+	fillRingSector(context, circle, thickness, angleStart, (angleEnd < splitAngle)? angleEnd : splitAngle);
+	graphics_context_set_fill_color(context, remainingColor);
+	fillRingSector(context, circle, thickness, (angleStart > splitAngle)? angleStart : splitAngle, angleEnd);
+}
+
+// complication slot text boxes, between the rings of the dial in bounds
+static void complicationBoxes(GRect bounds, GRect boxes[kSlotCount])
+{
+	int32_t		outerRadius = gTimeState.outerCircleOuterInset + gTimeState.outerCircleInnerInset + kComplicationRingClearance,
+				innerRadius = gTimeState.innerCircleOuterInset - kComplicationRingClearance,
+				midRadius = (outerRadius + innerRadius) / 2,
+				w = kDialScale(kComplicationHalfWidth), h = kDialScale(kComplicationHalfHeight),
+				x = bounds.origin.x, y = bounds.origin.y;
+
+	boxes[kSlotTop] = GRect(x + (bounds.size.w / 2) - w, y + midRadius - h, 2 * w, 2 * h);
+	boxes[kSlotLeft] = GRect(x + outerRadius, y + (bounds.size.h / 2) - h, innerRadius - outerRadius, 2 * h);
+	boxes[kSlotRight] = GRect(	x + bounds.size.w - innerRadius, y + (bounds.size.h / 2) - h - kDateBoxPadding,
+								innerRadius - outerRadius, 2 * h + 2 * kDateBoxPadding
+							);
+	boxes[kSlotBottom] = GRect(x + (bounds.size.w / 2) - w, y + bounds.size.h - midRadius - h, 2 * w, 2 * h);
+}
+
+// only the date's two digits fit the right-hand box in the larger type
+static GFont slotFont(int slot)
+{
+	struct ComplicationSlot const* s = &gSlots.slots[slot];
+	if(s->fit != kSlotFitNormal)
+		return(fonts_get_system_font(kSlotSmallFont));
+	return(fonts_get_system_font(((slot == kSlotRight) && (s->source == kSourceDate))? kDateFont : kComplicationFont));
+}
+
+// the slot's text as it's drawn, in string (kSlotTextSize + 1 bytes)
+static char const* slotText(int slot, char* string)
+{
+	struct ComplicationSlot const* s = &gSlots.slots[slot];
+	uint32_t split = (s->fit == kSlotFitTwoLines)? s->lineBreak : s->length;
+	memcpy(string, s->text, split);
+	string[split] = '\n';
+	memcpy(string + split + (split < s->length), s->text + split + (s->text[split] == ' '), s->length - split);
+	string[s->length + (split < s->length) - ((split < s->length) && (s->text[split] == ' '))] = 0;
+	return(string);
+}
+
+// whether the slot's text, as it would be drawn, fits its box
+static int slotTextFits(int slot)
+{
+	char string[kSlotTextSize + 1];
+	GRect const box = gLayout.slotBoxes[slot];
+	GSize const size = graphics_text_layout_get_content_size(	slotText(slot, string), slotFont(slot), box,
+																GTextOverflowModeWordWrap, GTextAlignmentCenter
+															);
+	return((size.w <= box.size.w) && (size.h <= box.size.h));
+}
+
+// fits the text of the slots that changed since the last frame to their boxes, so none is drawn
+// past its box's sector (the text is laid out, which the draw would do anyway, only on a change)
+static void measureSlots(void)
+{
+	for(int s = 0; gSlots.unmeasured && (s < kSlotCount); s++)
+	{
+		if(!(gSlots.unmeasured & (1 << s)))
+			continue;
+		gSlots.unmeasured &= ~(1 << s);
+
+		struct ComplicationSlot* slot = &gSlots.slots[s];
+		slot->length = strlen(slot->text);
+		slot->fit = kSlotFitNormal;
+		if(!slot->shown || slotTextFits(s))
+			continue;
+		slot->fit = kSlotFitSmall;
+		if(slotTextFits(s))
+			continue;
+
+		// two lines, broken at a space or else in the middle of the characters
+		char const* space = strchr(slot->text, ' ');
+		slot->fit = kSlotFitTwoLines;
+		slot->lineBreak = (space != 0)? (space - slot->text) : ((slot->length + 1) / 2);
+		while((slot->lineBreak > 0) && ((slot->text[slot->lineBreak] & 0xC0) == 0x80))
+			slot->lineBreak--;
+		if(slotTextFits(s))
+			continue;
+
+		// and as much of one line as fits, to the last whole character
+		slot->fit = kSlotFitSmall;
+		while((slot->length > 0) && !slotTextFits(s))
+		{
+			do
+				slot->length--;
+			while((slot->length > 0) && ((slot->text[slot->length] & 0xC0) == 0x80));
+		}
+	}
+}
+
+// draws the slots drawn into the complication cache (cached nonzero) or those drawn over it,
+// skipping any whose box lies outside the sector [angleStart, angleEnd)
+static void drawSlots(GContext* context, int cached, int32_t angleStart, int32_t angleEnd)
+{
+	for(int s = 0; s < kSlotCount; s++)
+	{
+		struct ComplicationSlot const* slot = &gSlots.slots[s];
+		if(!slot->shown || (slotIsCached(s) != cached) || !sectorIntersectsBox(gLayout.slotSectors[s], angleStart, angleEnd))
+			continue;
+
+		// the text is drawn from the slot: the names are multibyte UTF-8 in several languages
+		char string[kSlotTextSize + 1];
+		graphics_context_set_text_color(context, slot->color);
+		graphics_draw_text(		context, slotText(s, string), slotFont(s), gLayout.slotBoxes[s],
+								GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
+							);
+	}
+}
+
+// copies the whole framebuffer into the complication cache
+static void captureComplicationCache(GContext* context)
+{
+	GBitmap* frame = graphics_capture_frame_buffer(context);
+	if(frame == 0)
+		return;
+
+	GRect const bounds = gbitmap_get_bounds(gComplicationCache);
+	for(int y = 0; y < bounds.size.h; y++)
+	{
+		GBitmapDataRowInfo	frameRow = gbitmap_get_data_row_info(frame, y),
+							cacheRow = gbitmap_get_data_row_info(gComplicationCache, y);
+		if(frameRow.max_x >= frameRow.min_x)
+			memcpy(&cacheRow.data[frameRow.min_x], &frameRow.data[frameRow.min_x], frameRow.max_x - frameRow.min_x + 1);
+	}
+
+	graphics_release_frame_buffer(context, frame);
+	gComplicationCacheValid = 1;
+}
+
+// Everything the cache is used for is drawn in one of a few colors, each in its own place: the
+// outer background outside the minute ring, the background inside it, and each cached slot's text
+// within its box.  The system fonts are 1-bit, so when only the slots' colors change, the cache's
+// pixels are swapped to the new ones where they stand rather than drawn again.  That can't be done
+// where a box's text was the background's color and now isn't, nor for colors that aren't opaque,
+// nor where the display has color for the backgrounds: their edges are antialiased, blending them
+// with the rings and each other into colors no swap would find.  Then this returns 0 so the cache
+// is drawn afresh.
+static int recolorComplicationCache(struct TimeState const* previous)
+{
+	if((gComplicationCache == 0) || !gComplicationCacheValid)
+		return(0);
+#if defined(PBL_COLOR)
+	if(		(previous->backgroundColor.argb != gTimeState.backgroundColor.argb)
+		||	(previous->outerBackgroundColor.argb != gTimeState.outerBackgroundColor.argb)
+	)
+		return(0);
+#endif
+
+	// the box, and the colors in it and what they become, of each slot; then the rest of the dial
+	// inside the minute ring, and outside it
+	struct RecolorRegion
+	{
+		GRect		box;
+		uint32_t	count;
+		uint8_t		from[2], to[2];
+	} regions[kSlotCount + 2] = {{{{0}}}};
+
+	for(int s = 0; s < kSlotCount; s++)
+	{
+		regions[s].box = gLayout.slotBoxes[s];
+		if(gSlots.slots[s].shown && slotIsCached(s))
+		{
+			regions[s].from[0] = slotColor(previous, s).argb;
+			regions[s].to[0] = slotColor(&gTimeState, s).argb;
+			regions[s].count = 1;
+		}
+	}
+
+	for(int i = 0; i < kSlotCount + 2; i++)
+	{
+		struct RecolorRegion* region = &regions[i];
+		region->from[region->count] = ((i <= kSlotCount)? previous->backgroundColor : previous->outerBackgroundColor).argb;
+		region->to[region->count] = ((i <= kSlotCount)? gTimeState.backgroundColor : gTimeState.outerBackgroundColor).argb;
+		region->count++;
+
+		if((region->count == 2) && (region->from[0] == region->from[1]) && (region->to[0] != region->to[1]))
+			return(0);
+		for(uint32_t c = 0; c < region->count; c++)
+		{
+			if(((region->from[c] & 0xC0) != 0xC0) || ((region->to[c] & 0xC0) != 0xC0))
+				return(0);
+		}
+	}
+
+	// work in half-pixels so pixel centers are integers, as restoreComplicationSector does
+	GRect const bounds = gbitmap_get_bounds(gComplicationCache);
+	int32_t	cx2 = 2 * gLayout.outerCircle.origin.x + gLayout.outerCircle.size.w,
+			cy2 = 2 * gLayout.outerCircle.origin.y + gLayout.outerCircle.size.h,
+			ring4 = gLayout.outerCircle.size.w * gLayout.outerCircle.size.w;
+	for(int32_t y = 0; y < bounds.size.h; y++)
+	{
+		GBitmapDataRowInfo row = gbitmap_get_data_row_info(gComplicationCache, y);
+		int32_t dy = 2 * y + 1 - cy2;
+		for(int32_t x = row.min_x; x <= row.max_x; x++)
+		{
+			int32_t dx = 2 * x + 1 - cx2;
+			struct RecolorRegion const* region = &regions[kSlotCount];
+			if((dx * dx + dy * dy) >= ring4)
+				region = &regions[kSlotCount + 1];
+			else
+			{
+				for(int i = 0; i < kSlotCount; i++)
+				{
+					GRect const* box = &regions[i].box;
+					if(		(x >= box->origin.x) && (x < box->origin.x + box->size.w)
+						&&	(y >= box->origin.y) && (y < box->origin.y + box->size.h)
+					)
+					{
+						region = &regions[i];
+						break;
+					}
+				}
+			}
+
+			for(uint32_t i = 0; i < region->count; i++)
+			{
+				if(row.data[x] == region->from[i])
+				{
+					row.data[x] = region->to[i];
+					break;
+				}
+			}
+		}
+	}
+	return(1);
+}
+
+// copies the cached pixels of the sector [angleStart, angleEnd) back into the framebuffer,
+// between fromInset and toInset from the edge of bounds but not between skipFrom and skipTo
+static void restoreComplicationSector(	GContext* context, GRect bounds, uint32_t fromInset, uint32_t toInset,
+										uint32_t skipFrom, uint32_t skipTo, int32_t angleStart, int32_t angleEnd
+									)
+{
+	// each piece must be a convex wedge for the edge tests below
+	if((angleEnd - angleStart) > 90)
+	{
+		int32_t angleMid = (angleStart + angleEnd) / 2;
+		restoreComplicationSector(context, bounds, fromInset, toInset, skipFrom, skipTo, angleStart, angleMid);
+		restoreComplicationSector(context, bounds, fromInset, toInset, skipFrom, skipTo, angleMid, angleEnd);
+		return;
+	}
+
+	GBitmap* frame = graphics_capture_frame_buffer(context);
+	if(frame == 0)
+		return;
+
+	// work in half-pixels so pixel centers are integers
+	int32_t	cx2 = 2 * bounds.origin.x + bounds.size.w,
+			cy2 = 2 * bounds.origin.y + bounds.size.h,
+			outerRadius = (bounds.size.w / 2) - fromInset,
+			innerRadius = (bounds.size.w / 2) - toInset,
+			outer4 = 4 * outerRadius * outerRadius,
+			inner4 = (innerRadius > 0)? (4 * innerRadius * innerRadius) : -1,
+			skipOuter4 = 4 * ((int32_t)(bounds.size.w / 2) - (int32_t)skipFrom) * ((int32_t)(bounds.size.w / 2) - (int32_t)skipFrom),
+			skipInner4 = 4 * ((int32_t)(bounds.size.w / 2) - (int32_t)skipTo) * ((int32_t)(bounds.size.w / 2) - (int32_t)skipTo);
+	if(skipTo <= skipFrom)
+		skipOuter4 = skipInner4 = 0;
+
+	// edge directions, clockwise from 12 o'clock, scaled by TRIG_MAX_RATIO
+	int32_t	startX = sin_lookup(DEG_TO_TRIGANGLE(angleStart)), startY = -cos_lookup(DEG_TO_TRIGANGLE(angleStart)),
+			endX = sin_lookup(DEG_TO_TRIGANGLE(angleEnd)), endY = -cos_lookup(DEG_TO_TRIGANGLE(angleEnd));
+
+	// bounding box of the wedge: the center, both outer corners and any cardinal point it spans
+	int32_t	minX = cx2 / 2, maxX = cx2 / 2, minY = cy2 / 2, maxY = cy2 / 2,
+			cornerX[2] = {(cx2 / 2) + (startX * outerRadius) / TRIG_MAX_RATIO, (cx2 / 2) + (endX * outerRadius) / TRIG_MAX_RATIO},
+			cornerY[2] = {(cy2 / 2) + (startY * outerRadius) / TRIG_MAX_RATIO, (cy2 / 2) + (endY * outerRadius) / TRIG_MAX_RATIO};
+	for(int i = 0; i < 2; i++)
+	{
+		if(cornerX[i] < minX)	minX = cornerX[i];
+		if(cornerX[i] > maxX)	maxX = cornerX[i];
+		if(cornerY[i] < minY)	minY = cornerY[i];
+		if(cornerY[i] > maxY)	maxY = cornerY[i];
+	}
+	for(int32_t cardinal = 0; cardinal < 360; cardinal += 90)
+	{
+		if((((cardinal - angleStart) % 360) + 360) % 360 >= (angleEnd - angleStart))
+			continue;
+		if(cardinal == 0)	minY = (cy2 / 2) - outerRadius;
+		if(cardinal == 90)	maxX = (cx2 / 2) + outerRadius;
+		if(cardinal == 180)	maxY = (cy2 / 2) + outerRadius;
+		if(cardinal == 270)	minX = (cx2 / 2) - outerRadius;
+	}
+
+	GRect const frameBounds = gbitmap_get_bounds(frame);
+	if(minY < 0)	minY = 0;
+	if(maxY >= frameBounds.size.h)	maxY = frameBounds.size.h - 1;
+
+	for(int32_t y = minY; y <= maxY; y++)
+	{
+		GBitmapDataRowInfo	frameRow = gbitmap_get_data_row_info(frame, y),
+							cacheRow = gbitmap_get_data_row_info(gComplicationCache, y);
+		int32_t	dy = 2 * y + 1 - cy2,
+				fromX = (minX > frameRow.min_x)? minX : frameRow.min_x,
+				toX = (maxX < frameRow.max_x)? maxX : frameRow.max_x;
+
+		for(int32_t x = fromX; x <= toX; x++)
+		{
+			int32_t dx = 2 * x + 1 - cx2, d4 = dx * dx + dy * dy;
+			if((d4 >= outer4) || (d4 < inner4) || ((d4 < skipOuter4) && (d4 >= skipInner4)))
+				continue;
+			// inside [angleStart, angleEnd): clockwise of the start edge, not clockwise of the end edge
+			if(((startX * dy - startY * dx) < 0) || ((endX * dy - endY * dx) >= 0))
+				continue;
+			frameRow.data[x] = cacheRow.data[x];
+		}
+	}
+
+	graphics_release_frame_buffer(context, frame);
+}
+
+// paints the backgrounds and cached slots (from the cache, when it's valid) within the
+// sector [angleStart, angleEnd), from fromInset inward, but only in the two bands the rings and
+// innermost circle leave showing: the outer background outside the minute ring, and the
+// background between the rings
+static void paintBackgroundBands(GContext* context, uint32_t fromInset, int32_t angleStart, int32_t angleEnd)
+{
+	uint32_t	outerEnd = gTimeState.outerCircleOuterInset,
+				innerStart = gTimeState.outerCircleOuterInset + gTimeState.outerCircleInnerInset,
+				innerEnd = gTimeState.innerCircleOuterInset;
+	if(innerStart < fromInset)
+		innerStart = fromInset;
+
+	// both bands in one pass, skipping the minute ring between them
+	if(gComplicationCacheValid)
+	{
+		if((fromInset < innerEnd) && (innerStart < innerEnd))
+			restoreComplicationSector(context, gLayout.bounds, fromInset, innerEnd, outerEnd, innerStart, angleStart, angleEnd);
+		else if(fromInset < outerEnd)
+			restoreComplicationSector(context, gLayout.bounds, fromInset, outerEnd, 0, 0, angleStart, angleEnd);
+		return;
+	}
+
+	if(fromInset < outerEnd)
+	{
+		graphics_context_set_fill_color(context, gTimeState.outerBackgroundColor);
+		fillRingSector(context, insetCircle(gLayout.bounds, fromInset), outerEnd - fromInset, angleStart, angleEnd);
+	}
+	if(innerStart < innerEnd)
+	{
+		graphics_context_set_fill_color(context, gTimeState.backgroundColor);
+		fillRingSector(context, insetCircle(gLayout.bounds, innerStart), innerEnd - innerStart, angleStart, angleEnd);
+	}
+	drawSlots(context, 1, angleStart, angleEnd);
+}
+
+static void renderComplications(GContext* context)
+{
+	measureSlots();
+
+	// a delta redraw repaints the complications under the moved hands from the dial stage
+	if(gRedraw.mode == kRedrawDelta)
+		return;
+
+#if defined(PBL_RECT)
+	// the margins around the dial, as well as the dial
+	if(gComplicationCacheValid)
+		graphics_draw_bitmap_in_rect(context, gComplicationCache, gLayout.screen);
+	else
+	{
+		graphics_context_set_fill_color(context, gTimeState.outerBackgroundColor);
+		graphics_fill_rect(context, gLayout.screen, 0, GCornerNone);
+		paintBackgroundBands(context, gTimeState.outerCircleOuterInset, 0, 360);
+	}
+#else
+	paintBackgroundBands(context, 0, 0, 360);
+#endif
+
+	if(!gComplicationCacheValid && (gComplicationCache != 0) && !snapshotWriting())
+		captureComplicationCache(context);
+
+	drawSlots(context, 0, 0, 360);
+}
+
+// angular half-width (degrees) of the area a hand of the given stroke width covers, measured at
+// its innermost radius, with room for its round cap and antialiasing
+static int32_t handSweepMargin(uint32_t width, uint32_t innerRadius)
+{
+	return(((width + 2) * 29) / ((innerRadius > 0)? innerRadius : 1) + 2);
+}
+
+// where each time cell's ink lies around the dial, and which reach the hands' caps; until the
+// glyphs are built, the whole cell counts as ink
+static void updateTimeCellSectors(void)
+{
+	int32_t edgeRadius = (gLayout.hourInnerCircle.size.w / 2) - gLayout.innermostEdge;
+
+	gLayout.timeCellsAtEdge = 0;
+	for(int i = 0; i < 4; i++)
+	{
+		GRect ink = gLayout.timeCells[i];
+		if(gTimeGlyphs.built)
+			ink = GRect(ink.origin.x + gTimeGlyphs.ink.origin.x, ink.origin.y + gTimeGlyphs.ink.origin.y, gTimeGlyphs.ink.size.w, gTimeGlyphs.ink.size.h);
+
+		int32_t	dx0 = ink.origin.x - gLayout.center.x, dx1 = ink.origin.x + ink.size.w - gLayout.center.x,
+				dy0 = ink.origin.y - gLayout.center.y, dy1 = ink.origin.y + ink.size.h - gLayout.center.y,
+				dx = ((dx0 * dx0) > (dx1 * dx1))? dx0 : dx1,
+				dy = ((dy0 * dy0) > (dy1 * dy1))? dy0 : dy1;
+		if((dx * dx + dy * dy) <= (edgeRadius * edgeRadius))
+			continue;
+
+		gLayout.timeCellsAtEdge |= (1 << i);
+		if((dx0 <= 0) && (dx1 >= 0) && (dy0 <= 0) && (dy1 >= 0))
+		{
+			gLayout.timeCellSectors[i][0] = 0;
+			gLayout.timeCellSectors[i][1] = 360;
+		}
+		else
+		{
+			int32_t start, end;
+			boxSector(gLayout.bounds, ink, &start, &end);
+			gLayout.timeCellSectors[i][0] = start;
+			gLayout.timeCellSectors[i][1] = end;
+		}
+	}
+}
+
+static void updateLayout(GRect screen)
+{
+	GRect const bounds = kDialBounds;
+
+	gLayout.screen = screen;
+	gLayout.bounds = bounds;
+	gLayout.center = GPoint(bounds.origin.x + (bounds.size.w / 2), bounds.origin.y + (bounds.size.h / 2));
+
+	gLayout.outerCircle = insetCircle(bounds, gTimeState.outerCircleOuterInset);
+	gLayout.innerCircle = insetCircle(bounds, gTimeState.innerCircleOuterInset);
+	gLayout.hourCircle = insetCircle(bounds, gTimeState.hourHandInset);
+	gLayout.hourInnerCircle = insetCircle(gLayout.innerCircle, gTimeState.innerCircleInnerInset);
+	gLayout.timeBox = insetCircle(bounds, gTimeState.innerCircleOuterInset + gTimeState.innerCircleInnerInset + 1);
+
+	complicationBoxes(bounds, gLayout.slotBoxes);
+	for(int s = 0; s < kSlotCount; s++)
+	{
+		int32_t start, end;
+		boxSector(bounds, gLayout.slotBoxes[s], &start, &end);
+		gLayout.slotSectors[s][0] = start;
+		gLayout.slotSectors[s][1] = end;
+	}
+	gSlots.unmeasured = (1 << kSlotCount) - 1;
+
+	uint32_t handRadius = gLayout.hourInnerCircle.size.w / 2;
+	gLayout.minuteHandMargin = handSweepMargin(gTimeState.minuteHandWidth, handRadius);
+	gLayout.hourHandMargin = handSweepMargin(gTimeState.hourHandWidth, handRadius);
+	buildRingSpans(&gLayout.ringSpans[0], gLayout.outerCircle, gTimeState.outerCircleInnerInset);
+	buildRingSpans(&gLayout.ringSpans[1], gLayout.innerCircle, gTimeState.innerCircleInnerInset);
+	buildRingSpans(&gLayout.ringSpans[2], gLayout.outerCircle, kSecondsSweepThickness);
+
+	gLayout.innermostEdge = (	(gTimeState.hourHandWidth > gTimeState.minuteHandWidth)? gTimeState.hourHandWidth
+								: gTimeState.minuteHandWidth
+							) / 2 + 2;
+
+	// the grid the text engine would lay "00\n00" out in
+	GSize const grid = graphics_text_layout_get_content_size(	"00\n00", fonts_get_system_font(kTimeFont), gLayout.timeBox,
+																GTextOverflowModeWordWrap, GTextAlignmentCenter
+															);
+	for(int i = 0; i < 4; i++)
+	{
+		gLayout.timeCells[i] = GRect(	gLayout.timeBox.origin.x + (gLayout.timeBox.size.w - grid.w) / 2 + (i % 2) * (grid.w / 2),
+										gLayout.timeBox.origin.y + (i / 2) * (grid.h / 2), grid.w / 2, grid.h / 2
+									);
+	}
+	updateTimeCellSectors();
+
+	// chalk's screen edge cuts off the minute hand; elsewhere it stops short so its cap stays on the dial
+#if defined(PBL_ROUND)
+	GRect const minuteCircle = bounds;
+#else
+	GRect const minuteCircle = insetCircle(bounds, (gTimeState.minuteHandWidth / 2) + 1);
+#endif
+	for(int m = 0; m < 60; m++)
+	{
+		gLayout.minuteHand[m][0] = gpoint_from_polar(gLayout.hourInnerCircle, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(m * 6));
+		gLayout.minuteHand[m][1] = gpoint_from_polar(minuteCircle, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(m * 6));
+	}
+	for(int a = 0; a < 360; a++)
+	{
+		gLayout.hourHand[a][0] = gpoint_from_polar(gLayout.hourInnerCircle, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(a));
+		gLayout.hourHand[a][1] = gpoint_from_polar(gLayout.hourCircle, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(a));
+	}
+}
+
+// repaints everything beneath the hands within the sector [angleStart, angleEnd), from fromInset
+// inward to the innermost circle: backgrounds and complications (from the cache, when it's
+// valid) and both rings
+static void repaintSector(GContext* context, uint32_t fromInset, int32_t angleStart, int32_t angleEnd)
+{
+	GRect const bounds = gLayout.bounds;
+
+	uint32_t	minuteAngle, hourAngle;
+	currentDialAngles(&minuteAngle, &hourAngle);
+
+	uint32_t	outerRingEnd = gTimeState.outerCircleOuterInset + gTimeState.outerCircleInnerInset,
+				innerRingEnd = gTimeState.innerCircleOuterInset + gTimeState.innerCircleInnerInset,
+				inset;
+
+	paintBackgroundBands(context, fromInset, angleStart, angleEnd);
+	drawSlots(context, 0, angleStart, angleEnd);
+
+	inset = (fromInset > gTimeState.outerCircleOuterInset)? fromInset : gTimeState.outerCircleOuterInset;
+	if(inset < outerRingEnd)
+	{
+		paintRingSector(	context, insetCircle(bounds, inset), outerRingEnd - inset, minuteAngle,
+							gTimeState.elapsedOuterColor, gTimeState.elapsedOuterBackground, angleStart, angleEnd
 						);
+	}
 
-	// draw the inner angular section, which represents hours
 	int pm = (gTimeState.hours >= 12);
-	GRect innerCircle = GRect(		bounds.origin.x + gTimeState.innerCircleOuterInset, bounds.origin.y + gTimeState.innerCircleOuterInset,
-									bounds.size.w - (2 * gTimeState.innerCircleOuterInset), bounds.size.h - (2 * gTimeState.innerCircleOuterInset)
-								);
-	graphics_context_set_fill_color(context, pm? gTimeState.elapsedInnerBackground : gTimeState.elapsedInnerColor);
-	graphics_fill_radial(	context, innerCircle, GOvalScaleModeFillCircle,
-							gTimeState.innerCircleInnerInset, 0, DEG_TO_TRIGANGLE(hourAngle)
+	inset = (fromInset > gTimeState.innerCircleOuterInset)? fromInset : gTimeState.innerCircleOuterInset;
+	if(inset < innerRingEnd)
+	{
+		paintRingSector(	context, insetCircle(bounds, inset), innerRingEnd - inset, hourAngle,
+							pm? gTimeState.elapsedInnerBackground : gTimeState.elapsedInnerColor,
+							pm? gTimeState.elapsedInnerColor : gTimeState.elapsedInnerBackground,
+							angleStart, angleEnd
+						);
+	}
+}
+
+// paints the edge of the innermost circle over the hands' round caps within [angleStart,
+// angleEnd), marking the time cells it paints over for redrawing
+static void repaintInnermostEdge(GContext* context, int32_t angleStart, int32_t angleEnd)
+{
+	graphics_context_set_fill_color(context, gTimeState.innermostBackgroundColor);
+	fillRingSector(context, gLayout.hourInnerCircle, gLayout.innermostEdge, angleStart, angleEnd);
+
+	for(int i = 0; i < 4; i++)
+	{
+		if((gLayout.timeCellsAtEdge & (1 << i)) && sectorIntersectsBox(gLayout.timeCellSectors[i], angleStart, angleEnd))
+			gTimeGlyphs.stale |= (1 << i);
+	}
+}
+
+static void renderDial(GContext* context)
+{
+	uint32_t	hourAngle, minuteAngle;
+	currentDialAngles(&minuteAngle, &hourAngle);
+
+	GRect const outerCircle = gLayout.outerCircle;
+	GRect const innerCircle = gLayout.innerCircle;
+
+	uint32_t sweepAngle = (gSecondsBurst.remaining > 0)? ((gTimeState.seconds + 1) * 6) : 0;
+
+	if(gRedraw.mode == kRedrawDelta)
+	{
+		// erase the old minute hand, repainting the outer ring up to the new minute on the way;
+		// a seconds tick alone leaves the hand where it is
+		int32_t	from = (int32_t)gRedraw.minuteAngle - gLayout.minuteHandMargin,
+				to = (int32_t)gRedraw.minuteAngle + gLayout.minuteHandMargin;
+		int outerRingRepainted = ((minuteAngle != gRedraw.minuteAngle) || (gRedraw.parts & ~kRedrawPartSecondsSweep));
+		if(outerRingRepainted)
+		{
+			repaintSector(	context, 0, ((int32_t)minuteAngle < from)? (int32_t)minuteAngle : from,
+							((int32_t)minuteAngle > to)? (int32_t)minuteAngle : to
 						);
-	graphics_context_set_fill_color(context, pm? gTimeState.elapsedInnerColor : gTimeState.elapsedInnerBackground);
-	graphics_fill_radial(	context, innerCircle, GOvalScaleModeFillCircle,
-							gTimeState.innerCircleInnerInset, DEG_TO_TRIGANGLE(hourAngle), DEG_TO_TRIGANGLE(360)
+		}
+
+		// likewise the old hour hand, which doesn't reach the outer ring
+		if((hourAngle != gRedraw.hourAngle) || (gRedraw.parts & kRedrawPartHands))
+		{
+			int32_t handInset = (int32_t)gTimeState.hourHandInset - (int32_t)gTimeState.hourHandWidth / 2 - 1;
+			from = (int32_t)gRedraw.hourAngle - gLayout.hourHandMargin;
+			to = (int32_t)gRedraw.hourAngle + gLayout.hourHandMargin;
+			repaintSector(	context, (handInset > 0)? handInset : 0,
+							((int32_t)hourAngle < from)? (int32_t)hourAngle : from,
+							((int32_t)hourAngle > to)? (int32_t)hourAngle : to
 						);
+		}
 
-	GRect hourCircle = GRect(	bounds.origin.x + gTimeState.hourHandInset, bounds.origin.y + gTimeState.hourHandInset,
-								bounds.size.w - (2 * gTimeState.hourHandInset), bounds.size.h - (2 * gTimeState.hourHandInset)
+		// the slots that changed, and whatever a configuration change recolored
+		for(int s = 0; (gRedraw.parts & kRedrawPartSlots) && (s < kSlotCount); s++)
+		{
+			if(gSlots.dirty & (1 << s))
+			{
+				repaintSector(context, 0, gLayout.slotSectors[s][0], gLayout.slotSectors[s][1]);
+				gSlots.repaints++;
+			}
+		}
+		if(gRedraw.parts & kRedrawPartOuterRing)
+		{
+			paintRingSector(	context, outerCircle, gTimeState.outerCircleInnerInset, minuteAngle,
+								gTimeState.elapsedOuterColor, gTimeState.elapsedOuterBackground, 0, 360
 							);
-	GRect hourInnerCircle = GRect(		innerCircle.origin.x + gTimeState.innerCircleInnerInset, innerCircle.origin.y + gTimeState.innerCircleInnerInset,
-										innerCircle.size.w - (2 * gTimeState.innerCircleInnerInset), innerCircle.size.h - (2 * gTimeState.innerCircleInnerInset)
-									);
+		}
+		if(gRedraw.parts & kRedrawPartInnerRing)
+		{
+			int pm = (gTimeState.hours >= 12);
+			paintRingSector(	context, innerCircle, gTimeState.innerCircleInnerInset, hourAngle,
+								pm? gTimeState.elapsedInnerBackground : gTimeState.elapsedInnerColor,
+								pm? gTimeState.elapsedInnerColor : gTimeState.elapsedInnerBackground,
+								0, 360
+							);
+		}
+
+		// the seconds sweep: erase what's past its new end, then extend it (or redraw it, if the
+		// ring beneath it was just repainted)
+		if(sweepAngle < gRedraw.sweepAngle)
+		{
+			paintRingSector(	context, outerCircle, kSecondsSweepThickness, minuteAngle,
+								gTimeState.elapsedOuterColor, gTimeState.elapsedOuterBackground, sweepAngle, gRedraw.sweepAngle
+							);
+		}
+		if(sweepAngle > 0)
+		{
+			paintRingSector(	context, outerCircle, kSecondsSweepThickness, minuteAngle,
+								gTimeState.elapsedOuterBackground, gTimeState.elapsedOuterColor,
+								(outerRingRepainted || (sweepAngle < gRedraw.sweepAngle))? 0 : gRedraw.sweepAngle, sweepAngle
+							);
+		}
+	}
+	else
+	{
+		// draw the outer angular section, which represents minutes
+		paintRingSector(	context, outerCircle, gTimeState.outerCircleInnerInset, minuteAngle,
+							gTimeState.elapsedOuterColor, gTimeState.elapsedOuterBackground, 0, 360
+						);
+
+		// draw the inner angular section, which represents hours
+		int pm = (gTimeState.hours >= 12);
+		paintRingSector(	context, innerCircle, gTimeState.innerCircleInnerInset, hourAngle,
+							pm? gTimeState.elapsedInnerBackground : gTimeState.elapsedInnerColor,
+							pm? gTimeState.elapsedInnerColor : gTimeState.elapsedInnerBackground,
+							0, 360
+						);
+
+		if(sweepAngle > 0)
+		{
+			paintRingSector(	context, outerCircle, kSecondsSweepThickness, minuteAngle,
+								gTimeState.elapsedOuterBackground, gTimeState.elapsedOuterColor, 0, sweepAngle
+							);
+		}
+	}
+
 	// draw the hour hand
 	graphics_context_set_stroke_color(context, gTimeState.hourHandColor);
 	graphics_context_set_stroke_width(context, gTimeState.hourHandWidth);
-	graphics_draw_line(		context, gpoint_from_polar(hourInnerCircle, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(hourAngle)),
-							gpoint_from_polar(hourCircle, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(hourAngle))
-						);
+	graphics_draw_line(context, gLayout.hourHand[hourAngle][0], gLayout.hourHand[hourAngle][1]);
 	
 	// draw the minute hand
 	graphics_context_set_stroke_color(context, gTimeState.minuteHandColor);
 	graphics_context_set_stroke_width(context, gTimeState.minuteHandWidth);
-	graphics_draw_line(		context, gpoint_from_polar(hourInnerCircle, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(minuteAngle)),
-							gpoint_from_polar(bounds, GOvalScaleModeFillCircle, DEG_TO_TRIGANGLE(minuteAngle))
-						);
+	graphics_draw_line(context, gLayout.minuteHand[minuteAngle / 6][0], gLayout.minuteHand[minuteAngle / 6][1]);
+
+	// innermost circle: all of it, unless the time is drawn from glyphs that are still there,
+	// in which case only over the hands' caps, where they are and where they were
+	if(!gTimeGlyphs.built || (gRedraw.mode != kRedrawDelta) || (gRedraw.parts & kRedrawPartInnermost))
+	{
+		graphics_context_set_fill_color(context, gTimeState.innermostBackgroundColor);
+		graphics_fill_circle(context, gLayout.center, gLayout.hourInnerCircle.size.w / 2);
+		memset(gTimeGlyphs.drawn, kTimeGlyphNone, sizeof(gTimeGlyphs.drawn));
+	}
+	else
+	{
+		struct { uint32_t from, to; int32_t margin; } const hands[] =
+		{
+			{gRedraw.minuteAngle, minuteAngle, gLayout.minuteHandMargin},
+			{gRedraw.hourAngle, hourAngle, gLayout.hourHandMargin},
+		};
+		for(unsigned int i = 0; i < sizeof(hands) / sizeof(hands[0]); i++)
+		{
+			repaintInnermostEdge(	context, (int32_t)((hands[i].from < hands[i].to)? hands[i].from : hands[i].to) - hands[i].margin,
+									(int32_t)((hands[i].from > hands[i].to)? hands[i].from : hands[i].to) + hands[i].margin
+								);
+		}
+	}
+
+	// the inner stage only draws text over this, so the frame is complete
+	gRedraw.minuteAngle = minuteAngle;
+	gRedraw.hourAngle = hourAngle;
+	gRedraw.sweepAngle = sweepAngle;
+	gRedraw.mode = kRedrawNone;
+	gRedraw.parts = 0;
+	gSlots.dirty = 0;
+#if SWEEP_ON_APPEAR
+	gSweep.framesDrawn += (gSweep.animation != 0) && !gSweep.drawn;
+	gSweep.drawn = 1;
+#endif
+}
+
+// rasterizes the glyphs through the text engine, one at a time in the middle of the innermost
+// circle, then clears the circle; without the framebuffer, the atlas isn't built
+static void buildTimeGlyphs(GContext* context)
+{
+	GRect const cell = gLayout.timeCells[0];
+	if((cell.size.w > kTimeGlyphMaxWidth) || (cell.size.h > kTimeGlyphMaxHeight))
+		return;
+
+	GRect const scratch = GRect(gLayout.center.x - (cell.size.w / 2), gLayout.center.y - (cell.size.h / 2), cell.size.w, cell.size.h);
+	int16_t inkLeft = cell.size.w, inkTop = cell.size.h, inkRight = 0, inkBottom = 0;
+
+	int g;
+	for(g = 0; g < kTimeGlyphCount; g++)
+	{
+		char const glyph[2] = {(g == kTimeGlyphSpace)? ' ' : ('0' + g), 0};
+
+		graphics_context_set_fill_color(context, GColorBlack);
+		graphics_fill_rect(context, scratch, 0, GCornerNone);
+		graphics_context_set_text_color(context, GColorWhite);
+		graphics_draw_text(		context, glyph, fonts_get_system_font(kTimeFont), scratch,
+								GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
+							);
+
+		GBitmap* frame = graphics_capture_frame_buffer(context);
+		if(frame == 0)
+			break;
+		for(int y = 0; y < scratch.size.h; y++)
+		{
+			GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame, scratch.origin.y + y);
+			uint32_t mask = 0;
+			for(int x = 0; x < scratch.size.w; x++)
+			{
+				if(row.data[scratch.origin.x + x] != GColorWhite.argb)
+					continue;
+				mask |= (1u << x);
+				if(x < inkLeft)			inkLeft = x;
+				if(x >= inkRight)		inkRight = x + 1;
+				if(y < inkTop)			inkTop = y;
+				if(y >= inkBottom)		inkBottom = y + 1;
+			}
+			gTimeGlyphs.masks[g][y] = mask;
+		}
+		graphics_release_frame_buffer(context, frame);
+	}
+
+	if(g == kTimeGlyphCount)
+	{
+		gTimeGlyphs.ink = (inkRight > inkLeft)? GRect(inkLeft, inkTop, inkRight - inkLeft, inkBottom - inkTop) : GRect(0, 0, 0, 0);
+		gTimeGlyphs.built = 1;
+		updateTimeCellSectors();
+	}
 
-	// innermost circle
 	graphics_context_set_fill_color(context, gTimeState.innermostBackgroundColor);
-	graphics_fill_circle(context, center, hourInnerCircle.size.w / 2);
+	graphics_fill_circle(context, gLayout.center, gLayout.hourInnerCircle.size.w / 2);
+	memset(gTimeGlyphs.drawn, kTimeGlyphNone, sizeof(gTimeGlyphs.drawn));
 }
 
-static void onInnerLayerRender(struct Layer* layer, GContext* context)
+// draws the glyphs into the time cells that need them, erasing what's left of the old ones;
+// returns 0, and drops the atlas to be built again, if the framebuffer isn't available
+static int drawTimeGlyphs(GContext* context, uint8_t const glyphs[4])
 {
-	GRect bounds = layer_get_bounds(layer);
+	if(!gTimeGlyphs.stale && (memcmp(glyphs, gTimeGlyphs.drawn, sizeof(gTimeGlyphs.drawn)) == 0))
+		return(1);
+
+	// the glyphs stand in for the text engine's, which doesn't antialias
+	graphics_context_set_antialiased(context, false);
+	GBitmap* frame = graphics_capture_frame_buffer(context);
+	graphics_context_set_antialiased(context, true);
+	if(frame == 0)
+	{
+		gTimeGlyphs.built = 0;
+		return(0);
+	}
 
-	GPoint const center = GPoint(bounds.size.w / 2, bounds.size.h / 2);
+	GRect const frameBounds = gbitmap_get_bounds(frame), ink = gTimeGlyphs.ink;
+	uint8_t const text = gTimeState.innermostTextColor.argb, background = gTimeState.innermostBackgroundColor.argb;
 
-	uint32_t	innerCircleLayerInset = gTimeState.innerCircleOuterInset + gTimeState.innerCircleInnerInset + 1,
-				innerRadius = center.x - innerCircleLayerInset;
+	for(int i = 0; i < 4; i++)
+	{
+		if((glyphs[i] == gTimeGlyphs.drawn[i]) && !(gTimeGlyphs.stale & (1 << i)))
+			continue;
 
-	GRect hourInnerBox = GRect(		center.x - innerRadius, center.y - innerRadius,
-									2 * innerRadius, 2 * innerRadius
-								);
-	
-	if(!(gTimeState.timeStyle & kOptionHideDigitalTime))
+		GRect const cell = gLayout.timeCells[i];
+		uint8_t const drawn = gTimeGlyphs.drawn[i];
+		for(int y = ink.origin.y; y < ink.origin.y + ink.size.h; y++)
+		{
+			if(((cell.origin.y + y) < 0) || ((cell.origin.y + y) >= frameBounds.size.h))
+				continue;
+
+			GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame, cell.origin.y + y);
+			uint32_t	newInk = gTimeGlyphs.masks[glyphs[i]][y],
+						oldInk = (drawn != kTimeGlyphNone)? gTimeGlyphs.masks[drawn][y] : 0;
+			for(int x = ink.origin.x; x < ink.origin.x + ink.size.w; x++)
+			{
+				int32_t px = cell.origin.x + x;
+				if((px < row.min_x) || (px > row.max_x))
+					continue;
+				if(newInk & (1u << x))
+					row.data[px] = text;
+				else if(oldInk & (1u << x))
+					row.data[px] = background;
+			}
+		}
+		gTimeGlyphs.drawn[i] = glyphs[i];
+	}
+	gTimeGlyphs.stale = 0;
+
+	graphics_release_frame_buffer(context, frame);
+	return(1);
+}
+
+static void renderInner(GContext* context)
+{
+	GRect const hourInnerBox = gLayout.timeBox;
+
+	if(!(gTimeState.timeStyle & kOptionHideDigitalTime) && !(PROFILE_RENDERING && PROFILE_RENDERING_OVERLAY))
 	{
-		graphics_context_set_text_color(context, gTimeState.innermostTextColor);
-	
 		char timeString[6];
 		int h = gTimeState.hours, m = gTimeState.minutes;
 
@@ -442,17 +3043,103 @@ static void onInnerLayerRender(struct Layer* layer, GContext* context)
 			h -= 12;
 		
 		// option: leading zero suppression: 0 = 09:41; 1 = 9:41
-		char const* fmt = ((gTimeState.timeStyle & kOptionHourLeadingZeroSuppression) && (h < 10))? " %1i\n%02i" : "%02i\n%02i";
-		
-		snprintf(timeString, 6, fmt, h, m);
+		int suppressZero = ((gTimeState.timeStyle & kOptionHourLeadingZeroSuppression) && (h < 10));
+
+		if(TIME_GLYPH_ATLAS && !gTimeGlyphs.built)
+			buildTimeGlyphs(context);
+
+		uint8_t const glyphs[4] = {suppressZero? kTimeGlyphSpace : (h / 10), h % 10, m / 10, m % 10};
+		if(!gTimeGlyphs.built || !drawTimeGlyphs(context, glyphs))
+		{
+			snprintf(timeString, 6, suppressZero? " %1i\n%02i" : "%02i\n%02i", h, m);
+
+			graphics_context_set_text_color(context, gTimeState.innermostTextColor);
+
+			graphics_draw_text(		context, timeString, fonts_get_system_font(kTimeFont),
+									hourInnerBox, GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
+								);
+		}
+	}
 
-		graphics_draw_text(		context, timeString, fonts_get_system_font(FONT_KEY_LECO_28_LIGHT_NUMBERS),
-								hourInnerBox, GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
+#if PROFILE_RENDERING && PROFILE_RENDERING_OVERLAY
+	// the last complete frame's render times, per stage, in place of the digital time
+	if(gProfile.frames > 1)
+	{
+		char profileString[24];
+		uint32_t index = (gProfile.frames - 1) % kProfileSamples;
+		snprintf(	profileString, sizeof(profileString), "C %u\nD %u\nI %u", gProfile.samples[index].ms[0],
+					gProfile.samples[index].ms[1], gProfile.samples[index].ms[2]
+				);
+		graphics_context_set_text_color(context, gTimeState.innermostTextColor);
+		graphics_draw_text(		context, profileString, fonts_get_system_font(FONT_KEY_GOTHIC_14),
+								GRect(hourInnerBox.origin.x, gLayout.center.y - 24, hourInnerBox.size.w, 48),
+								GTextOverflowModeWordWrap, GTextAlignmentCenter, 0
 							);
 	}
+#endif
+}
+
+
+
+#if PROFILE_RENDERING
+#define RENDER_STAGE(render, stage)	do { profileBegin(stage); render(context); profileEnd(stage); } while(0)
+#else
+#define RENDER_STAGE(render, stage)	render(context)
+#endif
+
+#if defined(PBL_COLOR)
+// writes the snapshot the last render encoded, once it has returned; the next full redraw
+// captures the complication cache it was encoded into again
+static void onSnapshotWriteTimer(void* data)
+{
+	gSnapshot.writer = 0;
+	writeSnapshot(gbitmap_get_data(gComplicationCache), gSnapshot.fits);
+	requestRedraw(kRedrawFull);
 }
+#endif
+
+// The whole face is one layer, drawn back to front in stages: the backgrounds and complications,
+// the rings and hands, then the digital time.  Each stage paints only what the later ones leave
+// showing, so on a full redraw most pixels are written once.
+static void onFaceLayerRender(struct Layer* layer, GContext* context)
+{
+#if defined(PBL_COLOR)
+	// a cold start's first frame is the snapshot, unless the appear work has already run
+	if(gSnapshot.pending)
+	{
+		gSnapshot.pending = 0;
+		GBitmap* frame = graphics_capture_frame_buffer(context);
+		int drawn = (frame != 0) && drawSnapshot(frame);
+		if(frame != 0)
+			graphics_release_frame_buffer(context, frame);
+		if(drawn)
+			return;
+	}
+#endif
 
+	RENDER_STAGE(renderComplications, kProfileStageComplications);
+	RENDER_STAGE(renderDial, kProfileStageDial);
+	RENDER_STAGE(renderInner, kProfileStageInner);
 
+#if defined(PBL_COLOR)
+	// the sweep's frames aren't the time, so a save waits for it to finish; it takes over the
+	// complication cache's bitmap until it's written, and without one there's nowhere to encode it
+	if(gSnapshot.due && !sweepRunning() && (gComplicationCache != 0) && (gSnapshot.writer == 0))
+	{
+		GBitmap* frame = graphics_capture_frame_buffer(context);
+		if(frame != 0)
+		{
+			gSnapshot.due = 0;
+			invalidateComplicationCache();
+			gSnapshot.fits = encodeSnapshot(frame, gbitmap_get_data(gComplicationCache));
+			graphics_release_frame_buffer(context, frame);
+			gSnapshot.writer = app_timer_register(0, &onSnapshotWriteTimer, 0);
+			if(gSnapshot.writer == 0)
+				onSnapshotWriteTimer(0);
+		}
+	}
+#endif
+}
 
 static void onWindowLoad(Window* window)
 {
@@ -460,57 +3147,42 @@ static void onWindowLoad(Window* window)
 
 	GRect bounds = layer_get_bounds(windowLayer);
 
-	// complications on bottom layer(s)
-	gComplicationLayer = layer_create(bounds);
-	layer_add_child(windowLayer, gComplicationLayer);
-	layer_set_update_proc(gComplicationLayer, &onComplicationLayerRender);
-
-	// then the dial/hands
-	gDialLayer = layer_create(bounds);
-	layer_add_child(windowLayer, gDialLayer);
-	layer_set_update_proc(gDialLayer, &onDialLayerRender);
-
-	// on the top is the inner circle layer
-	gInnerLayer = layer_create(bounds);
-	layer_add_child(windowLayer, gInnerLayer);
-	layer_set_update_proc(gInnerLayer, &onInnerLayerRender);
+	// the face paints every pixel on a full redraw; a clear background keeps the previous frame for delta redraws
+	window_set_background_color(window, GColorClear);
+
+	gFaceLayer = layer_create(bounds);
+	layer_add_child(windowLayer, gFaceLayer);
+	layer_set_update_proc(gFaceLayer, &onFaceLayerRender);
+
+	// without the memory for it, the complications are simply drawn every time; the 1-bit
+	// displays don't have the memory to spare, or the 8-bit framebuffer the cache copies
+#if defined(PBL_COLOR)
+	gComplicationCache = gbitmap_create_blank(bounds.size, GBitmapFormat8Bit);
+#endif
+	gComplicationCacheValid = 0;
+
+	// settings only change by configuration message after this, so the layout follows them there
+	loadSettings();
+	loadBatteryHistory();
+	reduceColors();
+	resolveLanguage();
+	updateLayout(bounds);
+
+#if defined(PBL_COLOR)
+	// without a snapshot, the first frame is the face's own, and there's one to save
+	SnapshotHeader header;
+	gSnapshot.pending = readSnapshotHeader(&header, bounds.size);
+	gSnapshot.due = !gSnapshot.pending;
+#endif
 }
 
-static void onWindowAppear(Window* window)
+// the appear work, which waits on a timer for a cold start's snapshot to go up first
+static void appearFace(void* data)
 {
-	if(persist_exists(0))
-	{
-		// @@temp hack
-		persist_read_data(0, (void*)&(gTimeState.elapsedOuterColor), kSaveSizeHack);
-	}
-	else
-	{
-		// initialize parameters to defaults
-		gTimeState.elapsedOuterColor = GColorDarkCandyAppleRed;
-		gTimeState.elapsedOuterBackground = GColorLightGray;
-		gTimeState.elapsedInnerColor = GColorBlue;
-		gTimeState.elapsedInnerBackground = GColorLightGray;
-		gTimeState.hourHandColor = GColorBlue;
-		gTimeState.minuteHandColor = GColorDarkCandyAppleRed;
-		gTimeState.innermostBackgroundColor = GColorWhite;
-		gTimeState.innermostTextColor = GColorBlack;
-		gTimeState.complicationMonthColor = GColorDarkGray;
-		gTimeState.complicationDateColor = GColorDarkGray;
-		gTimeState.complicationDayColor = GColorDarkGray;
-		gTimeState.complicationBatteryColor = GColorDarkGray;
-		gTimeState.complicationBatteryErrorColor = GColorDarkCandyAppleRed;
-		gTimeState.backgroundColor = GColorWhite;
-		gTimeState.outerBackgroundColor = GColorWhite;
-
-		gTimeState.outerCircleOuterInset = 12,
-		gTimeState.outerCircleInnerInset = 8,
-		gTimeState.innerCircleOuterInset = gTimeState.outerCircleOuterInset + 40,
-		gTimeState.innerCircleInnerInset = 5,
-		gTimeState.hourHandInset = gTimeState.outerCircleOuterInset + 25,
-		gTimeState.hourHandWidth = 7,
-		gTimeState.minuteHandWidth = 3;
-	}
-	
+#if defined(PBL_COLOR)
+	gSnapshot.pending = 0;
+#endif
+
 	// initialize to the current time
 	time_t now;
 	time(&now);
@@ -519,8 +3191,39 @@ static void onWindowAppear(Window* window)
 	// initialize battery level
 	onBatteryStatusChanged(battery_state_service_peek());
 
-	// initialize Bluetooth connection status
-	gTimeState.connectionLost = !connection_service_peek_pebble_app_connection();
+	// initialize Bluetooth connection status, unless a drop is still within its delay
+	if(gConnection.pending == 0)
+		gTimeState.connectionLost = !connection_service_peek_pebble_app_connection();
+
+	// the polled sources keep their last poll's values until their next, as they would have anyway
+	uint32_t sources = 0;
+	for(int source = 0; source < kSourceCount; source++)
+	{
+		if(kComplicationSources[source].refreshMinutes == 0)
+			sources |= kSourceBit(source);
+	}
+	refreshSlots(sources);
+
+	PROFILE_CAUSE(kProfileCauseAppear);
+	invalidateComplicationCache();
+	requestRedraw(kRedrawFull);
+	startSweep();
+
+	// from the timer, the face has to ask for its frame
+	if(gFaceLayer != 0)
+		layer_mark_dirty(gFaceLayer);
+}
+
+static void onWindowAppear(Window* window)
+{
+#if defined(PBL_COLOR)
+	if(gSnapshot.pending && (app_timer_register(0, &appearFace, 0) != 0))
+	{
+		layer_mark_dirty(gFaceLayer);
+		return;
+	}
+#endif
+	appearFace(0);
 }
 
 static void onWindowDisappear(Window* window)
@@ -530,85 +3233,162 @@ static void onWindowDisappear(Window* window)
 
 static void onWindowUnload(Window* window)
 {
-	;	// needed for watchfaces?
+	cancelSweep();
+	cancelRedraw();
+	if(gConnection.pending != 0)
+		app_timer_cancel(gConnection.pending);
+	gConnection.pending = 0;
+
+#if defined(PBL_COLOR)
+	// a snapshot still to be written is in the cache's bitmap
+	if(gSnapshot.writer != 0)
+	{
+		app_timer_cancel(gSnapshot.writer);
+		onSnapshotWriteTimer(0);
+	}
+#endif
+	gbitmap_destroy(gComplicationCache);
+	gComplicationCache = 0;
+	gComplicationCacheValid = 0;
+}
+
+// applies one configuration value, returning the kRedrawPart*s it affects
+static uint32_t applyConfigValue(uint32_t key, uint32_t value)
+{
+	GColor color = (GColor){.argb = (uint8_t)value};
+	switch(key)
+	{
+	case KEY_ELAPSED_OUTER_COLOR:
+		gTimeState.elapsedOuterColor = color;
+		return(kRedrawPartOuterRing);
+	case KEY_ELAPSED_OUTER_BACKGROUND:
+		gTimeState.elapsedOuterBackground = color;
+		return(kRedrawPartOuterRing);
+	case KEY_ELAPSED_INNER_COLOR:
+		gTimeState.elapsedInnerColor = color;
+		return(kRedrawPartInnerRing);
+	case KEY_ELAPSED_INNER_BACKGROUND:
+		gTimeState.elapsedInnerBackground = color;
+		return(kRedrawPartInnerRing);
+	case KEY_INNERMOST_BACKGROUND_COLOR:
+		gTimeState.innermostBackgroundColor = color;
+		return(kRedrawPartInnermost);
+	case KEY_INNERMOST_TEXT_COLOR:
+		gTimeState.innermostTextColor = color;
+		return(kRedrawPartInnermost);
+	case KEY_HOUR_HAND_COLOR:
+		gTimeState.hourHandColor = color;
+		return(kRedrawPartHands);
+	case KEY_MINUTE_HAND_COLOR:
+		gTimeState.minuteHandColor = color;
+		return(kRedrawPartHands);
+	case KEY_COMPLICATION_MONTH_COLOR:
+		gTimeState.complicationMonthColor = color;
+		return(kRedrawPartBackgrounds);
+	case KEY_COMPLICATION_DATE_COLOR:
+		gTimeState.complicationDateColor = color;
+		return(kRedrawPartBackgrounds);
+	case KEY_COMPLICATION_DAY_COLOR:
+		gTimeState.complicationDayColor = color;
+		return(kRedrawPartBackgrounds);
+	case KEY_COMPLICATION_BATTERY_COLOR:
+		// the slots that show it repaint, or recolor the cache, when they're refreshed
+		gTimeState.complicationBatteryColor = color;
+		return(0);
+	case KEY_COMPLICATION_BATTERY_ERROR_COLOR:
+		gTimeState.complicationBatteryErrorColor = color;
+		return(0);
+	case KEY_FLAGS:
+		gTimeState.timeStyle = (value & 0xFFFF);
+		gTimeState.hourHandWidth = ((value >> 16) & 0xFF);
+		gTimeState.minuteHandWidth = ((value >> 24) & 0xFF);
+		return(kRedrawPartEverything);
+	case KEY_FLAGS2:
+		gTimeState.timeStyle2 = value;
+		resolveLanguage();
+		return(kRedrawPartEverything);
+	case KEY_BACKGROUND_COLOR:
+		gTimeState.backgroundColor = color;
+		return(kRedrawPartBackgrounds);
+	case KEY_OUTER_BACKGROUND_COLOR:
+		gTimeState.outerBackgroundColor = color;
+		return(kRedrawPartBackgrounds);
+	case KEY_QUIET_HOURS:
+		// takes effect from the next minute tick
+		gTimeState.quietHours = validQuietHours(value);
+		return(0);
+	case KEY_COMPLICATIONS:
+		// which slots are cached changes with what they show
+		gTimeState.complications = value;
+		return(kRedrawPartEverything);
+	}
+	return(0);
 }
 
 void onAppMessageReceived(DictionaryIterator* it, void* context)
 {
-	Tuple* tuple = dict_read_first(it);
-	while(tuple != 0)
+	Tuple* tuple = dict_find(it, KEY_CONFIG);
+	if((tuple == 0) || (tuple->type != TUPLE_BYTE_ARRAY) || (tuple->length < 1))
+		return;
+
+	uint8_t const* data = tuple->value->data;
+	if(data[0] != kConfigVersion)
+		return;
+
+	struct TimeState const previous = gTimeState;
+	uint32_t parts = 0;
+	for(uint32_t i = 1; i < tuple->length;)
 	{
-		switch(tuple->key)
-		{
-		case KEY_ELAPSED_OUTER_COLOR:
-			gTimeState.elapsedOuterColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_ELAPSED_OUTER_BACKGROUND:
-			gTimeState.elapsedOuterBackground = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_ELAPSED_INNER_COLOR:
-			gTimeState.elapsedInnerColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_ELAPSED_INNER_BACKGROUND:
-			gTimeState.elapsedInnerBackground = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_INNERMOST_BACKGROUND_COLOR:
-			gTimeState.innermostBackgroundColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_INNERMOST_TEXT_COLOR:
-			gTimeState.innermostTextColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_HOUR_HAND_COLOR:
-			gTimeState.hourHandColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_MINUTE_HAND_COLOR:
-			gTimeState.minuteHandColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_COMPLICATION_MONTH_COLOR:
-			gTimeState.complicationMonthColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_COMPLICATION_DATE_COLOR:
-			gTimeState.complicationDateColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_COMPLICATION_DAY_COLOR:
-			gTimeState.complicationDayColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_COMPLICATION_BATTERY_COLOR:
-			gTimeState.complicationBatteryColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_COMPLICATION_BATTERY_ERROR_COLOR:
-			gTimeState.complicationBatteryErrorColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_FLAGS:
-			{
-				unsigned int value = tuple->value->uint32;
-				gTimeState.timeStyle = (value & 0xFFFF);
-				gTimeState.hourHandWidth = ((value >> 16) & 0xFF);
-				gTimeState.minuteHandWidth = ((value >> 24) & 0xFF);
-			}
-			break;
-		case KEY_FLAGS2:
-			gTimeState.timeStyle2 = tuple->value->uint32;
-			break;
-		case KEY_BACKGROUND_COLOR:
-			gTimeState.backgroundColor = GColorFromHEX(tuple->value->uint32);
-			break;
-		case KEY_OUTER_BACKGROUND_COLOR:
-			gTimeState.outerBackgroundColor = GColorFromHEX(tuple->value->uint32);
+		uint32_t	key = data[i++],
+					size = kConfigValueSize(key),
+					value = 0;
+
+		// past an unknown key there's no telling where the next one starts
+		if((key >= kConfigKeyCount) || ((i + size) > tuple->length))
 			break;
-		}
-		tuple = dict_read_next(it);
+
+		for(uint32_t b = 0; b < size; b++)
+			value |= ((uint32_t)data[i + b] << (8 * b));
+		i += size;
+
+		parts |= applyConfigValue(key, value);
 	}
 
-	// @@temp hack
-	persist_write_data(0, (void*)&(gTimeState.elapsedOuterColor), kSaveSizeHack);
-	
-	if(gDialLayer != 0)
-		layer_mark_dirty(gDialLayer);
-	if(gInnerLayer != 0)
-		layer_mark_dirty(gInnerLayer);
-	if(gComplicationLayer != 0)
-		layer_mark_dirty(gComplicationLayer);
+	reduceColors();
+	saveSettings();
+
+	// the slots take the new settings; those drawn over the cache repaint on their own, and a
+	// recolored cache or a full redraw covers the rest.  Short of a full redraw, a cached slot
+	// only changes color (as the bottom slot does with the battery's), so the cache is recolored
+	uint32_t changed = refreshSlots(kSourcesAll);
+	if(liveSlots(changed) != changed)
+		parts |= kRedrawPartBackgrounds;
+	changed = liveSlots(changed);
+	gSlots.dirty |= changed;
+	if(changed != 0)
+		parts |= kRedrawPartSlots;
+
+	PROFILE_CAUSE(kProfileCauseConfig);
+#if defined(PBL_COLOR)
+	gSnapshot.due = 1;	// so a cold start doesn't show the old settings
+#endif
+	if(parts & kRedrawPartEverything)
+	{
+		updateLayout(gLayout.screen);
+		invalidateComplicationCache();
+		requestRedraw(kRedrawFull);
+	}
+	else if(parts & kRedrawPartBackgrounds)
+	{
+		// the layout stands, and so does the cache with its colors swapped
+		if(!recolorComplicationCache(&previous))
+			invalidateComplicationCache();
+		requestRedraw(kRedrawFull);
+	}
+	else
+		requestRedrawParts(parts);
+
+	scheduleRedraw();
 }
 
 void onAppMessageDropped(AppMessageResult reason, void* context)
@@ -629,7 +3409,7 @@ int main(void)
 	};
 	window_set_window_handlers(gWindow, handlers);
 
-	tick_timer_service_subscribe(YEAR_UNIT | MONTH_UNIT | DAY_UNIT | HOUR_UNIT | MINUTE_UNIT, &onTimeChanged);
+	tick_timer_service_subscribe(kMinuteTickUnits, &onTimeChanged);
 	
 	accel_tap_service_subscribe(&onAccelerometerEvent);
 
@@ -644,7 +3424,8 @@ int main(void)
 
 	//app_sync_init(struct AppSync * s, uint8_t * buffer, const uint16_t buffer_size, const Tuplet *const keys_and_initial_values, const uint8_t count, AppSyncTupleChangedCallback tuple_changed_callback, AppSyncErrorCallback error_callback, void * context)
 
-	app_message_open(256, 64);
+	// the watch only ever receives, and only the one configuration tuple
+	app_message_open(dict_calc_buffer_size(1, kConfigMaxSize), 16);
 	app_message_register_inbox_received(&onAppMessageReceived);
 	app_message_register_inbox_dropped(&onAppMessageDropped);
 	
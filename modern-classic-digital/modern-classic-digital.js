@@ -1,16 +1,53 @@
 Pebble.addEventListener("ready", function()
 {
 	console.log("PebbleKit JS ready!");
+
+	// the watch may have lost its settings since they were acknowledged (a reinstall, or a reset to
+	// the defaults), and there's no asking it, so the first configuration after a launch is sent whole
+	localStorage.removeItem(ackedConfigKey());
 });
 
 Pebble.addEventListener("showConfiguration", function()
 {
 	var url = "https://rawgit.com/kuym/PebbleFaces/master/modern-classic-digital/config/index.html";
+
+	// the page's preview is drawn for this watch's display
+	var watch = Pebble.getActiveWatchInfo? Pebble.getActiveWatchInfo() : null;
+	if(watch && watch.platform)
+		url += "?platform=" + encodeURIComponent(watch.platform);
 	console.log("Showing configuration page: " + url);
 
 	Pebble.openURL(url);
 });
 
+// Settings keys, as in the watchface's KEY_* enum.  Configuration goes to the watch as one byte
+// array under KEY_CONFIG: a version byte, then each changed setting's key and value, little-endian
+// (four bytes for KEY_FLAGS, KEY_FLAGS2, KEY_QUIET_HOURS and KEY_COMPLICATIONS, one GColor8 byte
+// for the colors).
+var KEY_ELAPSED_OUTER_COLOR = 0;
+var KEY_ELAPSED_OUTER_BACKGROUND = 1;
+var KEY_ELAPSED_INNER_COLOR = 2;
+var KEY_ELAPSED_INNER_BACKGROUND = 3;
+var KEY_INNERMOST_BACKGROUND_COLOR = 4;
+var KEY_INNERMOST_TEXT_COLOR = 5;
+var KEY_HOUR_HAND_COLOR = 6;
+var KEY_MINUTE_HAND_COLOR = 7;
+var KEY_COMPLICATION_MONTH_COLOR = 8;
+var KEY_COMPLICATION_DATE_COLOR = 9;
+var KEY_COMPLICATION_DAY_COLOR = 10;
+var KEY_COMPLICATION_BATTERY_COLOR = 11;
+var KEY_COMPLICATION_BATTERY_ERROR_COLOR = 12;
+var KEY_FLAGS = 13;
+var KEY_FLAGS2 = 14;
+var KEY_BACKGROUND_COLOR = 15;
+var KEY_OUTER_BACKGROUND_COLOR = 16;
+var KEY_CONFIG = 17;
+var KEY_QUIET_HOURS = 18;
+var KEY_COMPLICATIONS = 19;
+
+var kConfigVersion = 1;
+var kConfigKeyCount = 20;
+
 function parseColor(colorHex)
 {
 	if(colorHex.substr(0, 1) == "#")
@@ -22,6 +59,50 @@ function parseColor(colorHex)
 	return(isNaN(c)? 0 : c);
 }
 
+// the watch's 8-bit color (2 bits per channel, opaque) nearest to a hex color, as GColorFromHEX does
+function colorARGB8(colorHex)
+{
+	var c = parseColor(colorHex);
+	return(0xC0 | (((c >> 22) & 3) << 4) | (((c >> 14) & 3) << 2) | ((c >> 6) & 3));
+}
+
+// the settings the watch last acknowledged since the face launched, by key, or null if there's no
+// record for this watch
+function ackedConfigKey()
+{
+	return("ackedConfig:" + (Pebble.getWatchToken? Pebble.getWatchToken() : ""));
+}
+
+function loadAckedConfig()
+{
+	try
+	{
+		var acked = JSON.parse(localStorage.getItem(ackedConfigKey()));
+		return((acked && (acked.length == kConfigKeyCount))? acked : null);
+	}
+	catch(e)
+	{
+		return(null);
+	}
+}
+
+// the KEY_CONFIG byte array for the settings that differ from acked (all of them without a record)
+function configDelta(values, acked)
+{
+	var bytes = [kConfigVersion];
+	for(var key = 0; key < kConfigKeyCount; key++)
+	{
+		if((key == KEY_CONFIG) || (acked && (acked[key] == values[key])))
+			continue;
+
+		bytes.push(key);
+		var size = ((key == KEY_FLAGS) || (key == KEY_FLAGS2) || (key == KEY_QUIET_HOURS) || (key == KEY_COMPLICATIONS))? 4 : 1;
+		for(var b = 0; b < size; b++)
+			bytes.push((values[key] >>> (8 * b)) & 0xFF);
+	}
+	return(bytes);
+}
+
 Pebble.addEventListener("webviewclosed", function(e)
 {
 	var configData = JSON.parse(decodeURIComponent(e.response));
@@ -41,39 +122,72 @@ Pebble.addEventListener("webviewclosed", function(e)
 		| ((configData["optionHideConnectionLost_option"]? 1 : 0) << 9)
 		| ((configData["optionHideDigitalTime_option"]? 1 : 0) << 10)
 		| ((configData["optionVibrateOnDisconnection_option"]? 1 : 0) << 11)
+		| ((configData["optionBatteryTimeRemaining_option"]? 1 : 0) << 12)
 		;
 	
+	var secondsOnTap = parseInt(configData["secondsOnTap_value"], 10);
+	var connectionDelay = parseInt(configData["connectionDelay_value"], 10);
 	var flags2 = (parseInt(configData["language_picker"], 10) & 0xFF)
+		| ((isNaN(secondsOnTap)? 15 : (secondsOnTap & 0xFF)) << 8)
+		| ((isNaN(connectionDelay)? 10 : (connectionDelay & 0xFF)) << 16)
 		;
 	
+	var quietStart = parseInt(configData["quietHoursStart_value"], 10);
+	var quietEnd = parseInt(configData["quietHoursEnd_value"], 10);
+	var quietHours = ((isNaN(quietStart)? 23 : (quietStart % 24)) & 0xFF)
+		| (((isNaN(quietEnd)? 7 : (quietEnd % 24)) & 0xFF) << 8)
+		| ((parseInt(configData["quietHoursInterval_picker"], 10) & 0xFF) << 16)
+		;
+
+	// each slot's source in four bits, top, left, right then bottom, and the second time zone's
+	// offset from UTC in signed quarter hours
+	var complications = 0;
+	["Top", "Left", "Right", "Bottom"].forEach(function(slot, i)
+	{
+		complications |= ((parseInt(configData["slot" + slot + "_picker"], 10) & 0xF) << (i * 4));
+	});
+	var zoneOffset = parseFloat(configData["secondZoneOffset_picker"]);
+	complications |= ((Math.round((isNaN(zoneOffset)? 0 : zoneOffset) * 4) & 0xFF) << 16);
+
 	var customArcs = (configData["optionCustomArcColors_option"] || false);
-	var dict =
+	var values = [];
+	values[KEY_ELAPSED_OUTER_COLOR] = colorARGB8(customArcs? configData["elapsedOuterColor_picker"] : configData["minuteHandColor_picker"]);
+	values[KEY_ELAPSED_OUTER_BACKGROUND] = colorARGB8(customArcs? configData["elapsedOuterBackground_picker"] : configData["elapsedBackground_picker"]);
+	values[KEY_ELAPSED_INNER_COLOR] = colorARGB8(customArcs? configData["elapsedInnerColor_picker"] : configData["hourHandColor_picker"]);
+	values[KEY_ELAPSED_INNER_BACKGROUND] = colorARGB8(customArcs? configData["elapsedInnerBackground_picker"] : configData["elapsedBackground_picker"]);
+	values[KEY_INNERMOST_BACKGROUND_COLOR] = colorARGB8(configData["innermostBackgroundColor_picker"]);
+	values[KEY_INNERMOST_TEXT_COLOR] = colorARGB8(configData["innermostTextColor_picker"]);
+	values[KEY_HOUR_HAND_COLOR] = colorARGB8(configData["hourHandColor_picker"]);
+	values[KEY_MINUTE_HAND_COLOR] = colorARGB8(configData["minuteHandColor_picker"]);
+	values[KEY_COMPLICATION_MONTH_COLOR] = colorARGB8(configData["complicationMonthColor_picker"]);
+	values[KEY_COMPLICATION_DATE_COLOR] = colorARGB8(configData["complicationDateColor_picker"]);
+	values[KEY_COMPLICATION_DAY_COLOR] = colorARGB8(configData["complicationDayColor_picker"]);
+	values[KEY_COMPLICATION_BATTERY_COLOR] = colorARGB8(configData["complicationBatteryColor_picker"]);
+	values[KEY_COMPLICATION_BATTERY_ERROR_COLOR] = colorARGB8(configData["complicationBatteryErrorColor_picker"]);
+	values[KEY_FLAGS] = (flags >>> 0);
+	values[KEY_FLAGS2] = (flags2 >>> 0);
+	values[KEY_BACKGROUND_COLOR] = colorARGB8(configData["backgroundColor_picker"]);
+	values[KEY_OUTER_BACKGROUND_COLOR] = colorARGB8(configData["outerBackgroundColor_picker"]);
+	values[KEY_QUIET_HOURS] = (quietHours >>> 0);
+	values[KEY_COMPLICATIONS] = (complications >>> 0);
+
+	var bytes = configDelta(values, loadAckedConfig());
+	if(bytes.length == 1)
 	{
-		KEY_ELAPSED_OUTER_COLOR: parseColor(customArcs? configData["elapsedOuterColor_picker"] : configData["minuteHandColor_picker"]),
-		KEY_ELAPSED_OUTER_BACKGROUND: parseColor(customArcs? configData["elapsedOuterBackground_picker"] : configData["elapsedBackground_picker"]),
-		KEY_ELAPSED_INNER_COLOR: parseColor(customArcs? configData["elapsedInnerColor_picker"] : configData["hourHandColor_picker"]),
-		KEY_ELAPSED_INNER_BACKGROUND: parseColor(customArcs? configData["elapsedInnerBackground_picker"] : configData["elapsedBackground_picker"]),
-		KEY_INNERMOST_BACKGROUND_COLOR: parseColor(configData["innermostBackgroundColor_picker"]),
-		KEY_INNERMOST_TEXT_COLOR: parseColor(configData["innermostTextColor_picker"]),
-		KEY_HOUR_HAND_COLOR: parseColor(configData["hourHandColor_picker"]),
-		KEY_MINUTE_HAND_COLOR: parseColor(configData["minuteHandColor_picker"]),
-		KEY_COMPLICATION_MONTH_COLOR: parseColor(configData["complicationMonthColor_picker"]),
-		KEY_COMPLICATION_DATE_COLOR: parseColor(configData["complicationDateColor_picker"]),
-		KEY_COMPLICATION_DAY_COLOR: parseColor(configData["complicationDayColor_picker"]),
-		KEY_COMPLICATION_BATTERY_COLOR: parseColor(configData["complicationBatteryColor_picker"]),
-		KEY_COMPLICATION_BATTERY_ERROR_COLOR: parseColor(configData["complicationBatteryErrorColor_picker"]),
-		KEY_FLAGS: flags,
-		KEY_FLAGS2: flags2,
-		KEY_BACKGROUND_COLOR: parseColor(configData["backgroundColor_picker"]),
-		KEY_OUTER_BACKGROUND_COLOR: parseColor(configData["outerBackgroundColor_picker"]),
-	};
-
-	console.log("dict: " + JSON.stringify(dict));
-
-	// Send to watchapp
+		console.log("Configuration unchanged");
+		return;
+	}
+
+	var dict = {};
+	dict[KEY_CONFIG] = bytes;
+	console.log("config: " + JSON.stringify(bytes));
+
+	// Send to watchapp; only what the watch acknowledges counts as sent, so a failed send is
+	// folded into the next one
 	Pebble.sendAppMessage(dict, function()
 	{
-		console.log("Send successful: " + JSON.stringify(dict));
+		localStorage.setItem(ackedConfigKey(), JSON.stringify(values));
+		console.log("Send successful: " + bytes.length + " bytes");
 	}, function()
 	{
 		console.log("Send failed!");